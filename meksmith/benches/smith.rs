@@ -0,0 +1,117 @@
+//! Benchmarks for the parser and the C smith at several protocol scales.
+//!
+//! The inputs are produced by a deterministic synthetic generator, so the
+//! numbers are comparable between runs and releases: the same scale always
+//! benchmarks exactly the same source. Run with `cargo bench`.
+
+use criterion::{Criterion, criterion_group, criterion_main};
+
+use std::fmt::Write;
+
+/// Generates a meklang protocol with `definitions` top-level definitions.
+///
+/// Definitions are emitted in repeating blocks of four (enumeration,
+/// structure, union, type alias) that reference each other within the block,
+/// so the output exercises every definition kind and user-defined type
+/// lookups. The generator is purely index-driven and therefore deterministic.
+fn synthetic_protocol(definitions: usize) -> String {
+    let mut source = String::new();
+    for index in 0..definitions {
+        let block = index / 4;
+        match index % 4 {
+            0 => {
+                writeln!(source, "enum SynEnum{block} {{").unwrap();
+                writeln!(source, "    first = 1;").unwrap();
+                writeln!(source, "    second = 2;").unwrap();
+                writeln!(source, "    spare = 3..15;").unwrap();
+                writeln!(source, "}};").unwrap();
+            }
+            1 => {
+                writeln!(source, "struct SynStruct{block} {{").unwrap();
+                writeln!(source, "    [bits = 4] version: uint8;").unwrap();
+                writeln!(source, "    kind: SynEnum{block};").unwrap();
+                writeln!(source, "    payload: byte[16];").unwrap();
+                writeln!(source, "}};").unwrap();
+            }
+            2 => {
+                writeln!(source, "union SynUnion{block} {{").unwrap();
+                writeln!(source, "    1 => message: SynStruct{block};").unwrap();
+                writeln!(source, "    2..255 => raw: byte[];").unwrap();
+                writeln!(source, "}};").unwrap();
+            }
+            _ => {
+                writeln!(source, "using SynAlias{block} = SynStruct{block}[4];").unwrap();
+            }
+        }
+    }
+    source
+}
+
+/// Generates a chain of `depth` type aliases, each one a static array of the
+/// previous alias, ending in a deeply nested `TypeIdentifier` tree once the
+/// chain is resolved. Array types cannot nest syntactically in meklang, so an
+/// alias chain is the deepest nesting a source can express.
+fn deeply_nested_protocol(depth: usize) -> String {
+    let mut source = String::from("using Nested0 = uint8;\n");
+    for level in 1..depth {
+        let previous = level - 1;
+        writeln!(source, "using Nested{level} = Nested{previous}[2];").unwrap();
+    }
+    source
+}
+
+/// Generates a union with `arms` consecutive `RangeOfValues` arms, each
+/// covering a disjoint range of discriminator values.
+fn wide_union_protocol(arms: usize) -> String {
+    let mut source = String::from("union WideUnion {\n");
+    for arm in 0..arms {
+        let start = arm * 16;
+        let end = start + 15;
+        writeln!(source, "    {start}..{end} => arm{arm}: uint32;").unwrap();
+    }
+    source.push_str("};\n");
+    source
+}
+
+fn bench_parse(criterion: &mut Criterion) {
+    let mut group = criterion.benchmark_group("parse_protocol_to_ast");
+    for definitions in [10, 1_000, 50_000] {
+        let source = synthetic_protocol(definitions);
+        if definitions >= 50_000 {
+            group.sample_size(10);
+        }
+        group.bench_function(format!("{definitions}_definitions"), |bencher| {
+            bencher.iter(|| meksmith::parse_protocol_to_ast(&source).expect("Parsing failed"));
+        });
+    }
+    group.finish();
+
+    let mut group = criterion.benchmark_group("parse_protocol_to_ast_shapes");
+    let nested = deeply_nested_protocol(500);
+    group.bench_function("deeply_nested_500", |bencher| {
+        bencher.iter(|| meksmith::parse_protocol_to_ast(&nested).expect("Parsing failed"));
+    });
+    let wide = wide_union_protocol(1_000);
+    group.bench_function("wide_union_1000_arms", |bencher| {
+        bencher.iter(|| meksmith::parse_protocol_to_ast(&wide).expect("Parsing failed"));
+    });
+    group.finish();
+}
+
+fn bench_generate(criterion: &mut Criterion) {
+    let mut group = criterion.benchmark_group("generate_c_code");
+    for definitions in [10, 1_000, 50_000] {
+        let source = synthetic_protocol(definitions);
+        let protocol = meksmith::parse_protocol_to_ast(&source).expect("Parsing failed");
+        if definitions >= 50_000 {
+            group.sample_size(10);
+        }
+        group.bench_function(format!("{definitions}_definitions"), |bencher| {
+            bencher.iter(|| meksmith::smith_c::generate_c_code(&protocol));
+        });
+    }
+    group.finish();
+}
+
+criterion_group!(benches, bench_parse, bench_generate);
+criterion_main!(benches);
@@ -0,0 +1,248 @@
+//! Arena-backed variant of the AST for allocation-friendly walks.
+//!
+//! The parsed `Protocol` stores nested types behind a `Box` per node
+//! (`TypeIdentifier::StaticArray`/`DynamicArray`), scattering deeply
+//! aliased protocols across the heap. [`ArenaProtocol::from_protocol`]
+//! flattens every type tree into one contiguous [`TypeArena`]: nodes are
+//! referenced by index instead of pointer, identical subtrees are stored
+//! once, and the whole arena is dropped in a single free. Consumers doing
+//! recursive type walks can convert once and chase indices instead of boxes.
+//!
+//! The arena is built after parsing rather than inside it because the cached
+//! parser (see the `parser` module) is lifetime-erased and must produce
+//! owned nodes.
+
+use crate::ast::{
+    Attribute, Definition, EnumerationDefinition, Identifier, Protocol, TypeIdentifier, UnionField,
+};
+
+use std::collections::HashMap;
+
+/// Index of a type node inside its [`TypeArena`].
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct TypeId(u32);
+
+/// A single type node; the arena-resident counterpart of `TypeIdentifier`,
+/// with child nodes referenced by [`TypeId`] instead of `Box`.
+#[derive(Debug, Clone, PartialEq, Eq, Hash)]
+pub enum TypeNode {
+    Builtin(TypeIdentifier),
+    UserDefined(Identifier),
+    StaticArray { r#type: TypeId, size: u64 },
+    DynamicArray { r#type: TypeId },
+}
+
+/// All type nodes of a protocol in one contiguous allocation. Children are
+/// interned before their parents, so a node's id is always greater than the
+/// ids of everything it references.
+#[derive(Debug, Default)]
+pub struct TypeArena {
+    nodes: Vec<TypeNode>,
+    interned: HashMap<TypeNode, TypeId>,
+}
+
+impl TypeArena {
+    /// Returns the node behind an id issued by this arena.
+    pub fn get(&self, id: TypeId) -> &TypeNode {
+        &self.nodes[id.0 as usize]
+    }
+
+    /// Returns the number of distinct nodes in the arena.
+    pub fn len(&self) -> usize {
+        self.nodes.len()
+    }
+
+    /// Returns `true` if the arena holds no nodes.
+    pub fn is_empty(&self) -> bool {
+        self.nodes.is_empty()
+    }
+
+    /// Interns a type tree, reusing already-interned identical subtrees.
+    fn intern(&mut self, r#type: &TypeIdentifier) -> TypeId {
+        let node = match r#type {
+            TypeIdentifier::UserDefined(identifier) => TypeNode::UserDefined(identifier.clone()),
+            TypeIdentifier::StaticArray { r#type, size } => TypeNode::StaticArray {
+                r#type: self.intern(r#type),
+                size: *size,
+            },
+            TypeIdentifier::DynamicArray { r#type } => TypeNode::DynamicArray {
+                r#type: self.intern(r#type),
+            },
+            builtin => TypeNode::Builtin(builtin.clone()),
+        };
+
+        if let Some(id) = self.interned.get(&node) {
+            return *id;
+        }
+        let id = TypeId(self.nodes.len() as u32);
+        self.nodes.push(node.clone());
+        self.interned.insert(node, id);
+        id
+    }
+}
+
+/// A structure field with its type in the arena.
+#[derive(Debug, Clone, PartialEq)]
+pub struct ArenaStructureField {
+    pub name: Identifier,
+    pub r#type: TypeId,
+    pub attributes: Vec<Attribute>,
+}
+
+/// A union field with its type in the arena; discriminators are kept as an
+/// inclusive range, with single values as one-element ranges.
+#[derive(Debug, Clone, PartialEq)]
+pub struct ArenaUnionField {
+    pub name: Identifier,
+    pub r#type: TypeId,
+    pub first_discriminator: u64,
+    pub last_discriminator: u64,
+}
+
+/// The arena-resident counterpart of `Definition`. Enumerations carry no
+/// types and are shared with the boxed AST unchanged.
+#[derive(Debug, Clone, PartialEq)]
+pub enum ArenaDefinition {
+    Enumeration(EnumerationDefinition),
+    Structure {
+        name: Identifier,
+        fields: Vec<ArenaStructureField>,
+    },
+    Union {
+        name: Identifier,
+        fields: Vec<ArenaUnionField>,
+    },
+    Type {
+        new_type: Identifier,
+        r#type: TypeId,
+    },
+}
+
+/// An entire protocol with all type trees flattened into one [`TypeArena`].
+#[derive(Debug)]
+pub struct ArenaProtocol {
+    pub definitions: Vec<ArenaDefinition>,
+    pub arena: TypeArena,
+}
+
+impl ArenaProtocol {
+    /// Flattens a parsed protocol into the arena representation.
+    pub fn from_protocol(protocol: &Protocol) -> ArenaProtocol {
+        let mut arena = TypeArena::default();
+        let definitions = protocol
+            .definitions
+            .iter()
+            .map(|definition| match definition {
+                Definition::Enumeration(enumeration_def) => {
+                    ArenaDefinition::Enumeration(enumeration_def.clone())
+                }
+                Definition::Structure(structure_def) => ArenaDefinition::Structure {
+                    name: structure_def.name.clone(),
+                    fields: structure_def
+                        .fields
+                        .iter()
+                        .map(|field| ArenaStructureField {
+                            name: field.name.clone(),
+                            r#type: arena.intern(&field.r#type),
+                            attributes: field.attributes.clone(),
+                        })
+                        .collect(),
+                },
+                Definition::Union(union_def) => ArenaDefinition::Union {
+                    name: union_def.name.clone(),
+                    fields: union_def
+                        .fields
+                        .iter()
+                        .map(|field| match field {
+                            UnionField::SingleValue {
+                                name,
+                                r#type,
+                                discriminator,
+                            } => ArenaUnionField {
+                                name: name.clone(),
+                                r#type: arena.intern(r#type),
+                                first_discriminator: *discriminator,
+                                last_discriminator: *discriminator,
+                            },
+                            UnionField::RangeOfValues {
+                                name,
+                                r#type,
+                                start_discriminator,
+                                end_discriminator,
+                            } => ArenaUnionField {
+                                name: name.clone(),
+                                r#type: arena.intern(r#type),
+                                first_discriminator: *start_discriminator,
+                                last_discriminator: *end_discriminator,
+                            },
+                        })
+                        .collect(),
+                },
+                Definition::Type(type_def) => ArenaDefinition::Type {
+                    new_type: type_def.new_type.clone(),
+                    r#type: arena.intern(&type_def.r#type),
+                },
+            })
+            .collect();
+
+        ArenaProtocol { definitions, arena }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::parse_protocol_to_ast;
+
+    static SOURCE: &str = "using First = int32[10];\nusing Second = int32[10];\nstruct MyStruct {\n    field: First;\n    other: int32[10];\n};\n";
+
+    #[test]
+    fn test_identical_subtrees_are_stored_once() {
+        let protocol = parse_protocol_to_ast(SOURCE).expect("Parsing failed");
+        let arena_protocol = ArenaProtocol::from_protocol(&protocol);
+
+        // `int32`, `int32[10]` and `First` are each stored exactly once even
+        // though `int32[10]` appears in three definitions.
+        assert_eq!(arena_protocol.arena.len(), 3);
+    }
+
+    #[test]
+    fn test_nested_types_resolve_through_ids() {
+        let protocol = parse_protocol_to_ast(SOURCE).expect("Parsing failed");
+        let arena_protocol = ArenaProtocol::from_protocol(&protocol);
+
+        let ArenaDefinition::Type { new_type, r#type } = &arena_protocol.definitions[0] else {
+            panic!("Expected a type definition");
+        };
+        assert_eq!(new_type.name, "First");
+        let TypeNode::StaticArray { r#type, size } = arena_protocol.arena.get(*r#type) else {
+            panic!("Expected a static array node");
+        };
+        assert_eq!(*size, 10);
+        assert_eq!(
+            arena_protocol.arena.get(*r#type),
+            &TypeNode::Builtin(crate::ast::TypeIdentifier::Integer32)
+        );
+    }
+
+    #[test]
+    fn test_union_discriminators_become_ranges() {
+        let protocol = parse_protocol_to_ast(
+            "union Payload {\n    1 => first: uint8;\n    2..5 => second: uint16;\n};\n",
+        )
+        .expect("Parsing failed");
+        let arena_protocol = ArenaProtocol::from_protocol(&protocol);
+
+        let ArenaDefinition::Union { fields, .. } = &arena_protocol.definitions[0] else {
+            panic!("Expected a union definition");
+        };
+        assert_eq!(
+            (fields[0].first_discriminator, fields[0].last_discriminator),
+            (1, 1)
+        );
+        assert_eq!(
+            (fields[1].first_discriminator, fields[1].last_discriminator),
+            (2, 5)
+        );
+    }
+}
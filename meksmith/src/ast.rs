@@ -1,13 +1,17 @@
+use crate::intern::InternedString;
+
 /// Represents an identifier, which is a name used to refer to types, fields, etc.
+/// The name is interned, so identifiers with the same name share a single
+/// allocation and compare in O(1).
 #[derive(Debug, Clone, PartialEq, Eq, Hash)]
 pub struct Identifier {
-    pub name: String,
+    pub name: InternedString,
 }
 
 impl Identifier {
     pub fn new(name: &str) -> Self {
         Identifier {
-            name: name.to_string(),
+            name: InternedString::new(name),
         }
     }
 }
@@ -130,9 +134,14 @@ pub enum Definition {
     Type(TypeDefinition),
 }
 
-/// Represents the entire protocol, which consists of multiple definitions.
+/// Represents the entire protocol, which consists of multiple definitions and
+/// the paths of imported files (as written in the source, unresolved).
+/// Imports are resolved and merged by [`parse_protocol_with_imports`].
+///
+/// [`parse_protocol_with_imports`]: crate::parse_protocol_with_imports
 #[derive(Debug, Clone, PartialEq)]
 pub struct Protocol {
+    pub imports: Vec<String>,
     pub definitions: Vec<Definition>,
 }
 
@@ -140,7 +149,9 @@ pub struct Protocol {
 /// If the type identifier is a user-defined type, it returns the name.
 /// If it is a static or dynamic array, it recursively extracts the name from the contained type.
 /// If it is a built-in type, it returns `None`.
-fn extract_custom_type_identifier_name(type_identifier: &TypeIdentifier) -> Option<String> {
+pub(crate) fn extract_custom_type_identifier_name(
+    type_identifier: &TypeIdentifier,
+) -> Option<InternedString> {
     match type_identifier {
         TypeIdentifier::UserDefined(id) => Some(id.name.clone()),
         TypeIdentifier::StaticArray { r#type, .. } => extract_custom_type_identifier_name(r#type),
@@ -150,7 +161,9 @@ fn extract_custom_type_identifier_name(type_identifier: &TypeIdentifier) -> Opti
 }
 
 /// Extracts the names of all custom type identifiers from a structure definition.
-fn extract_structure_subtypes(structure_def: &StructureDefinition) -> Vec<String> {
+pub(crate) fn extract_structure_subtypes(
+    structure_def: &StructureDefinition,
+) -> Vec<InternedString> {
     structure_def
         .fields
         .iter()
@@ -159,7 +172,7 @@ fn extract_structure_subtypes(structure_def: &StructureDefinition) -> Vec<String
 }
 
 /// Extracts the names of all custom type identifiers from a union definition.
-fn extract_union_subtypes(union_def: &UnionDefinition) -> Vec<String> {
+pub(crate) fn extract_union_subtypes(union_def: &UnionDefinition) -> Vec<InternedString> {
     union_def
         .fields
         .iter()
@@ -173,129 +186,18 @@ fn extract_union_subtypes(union_def: &UnionDefinition) -> Vec<String> {
 /// Sorts the protocol definitions using their dependencies, meaning that if
 /// a type `A` depends on type `B`, then `B` should appear before `A` in the sorted list.
 /// This function returns a new `Protocol` with the definitions sorted accordingly.
-/// If a circular dependency is detected, it returns an error.
+/// The order comes from one [`DependencyGraph`] pass; a circular dependency is
+/// reported as an error spelling out the whole reference chain.
+///
+/// [`DependencyGraph`]: crate::graph::DependencyGraph
 pub(crate) fn sort_protocol_by_dependencies(protocol: &Protocol) -> Result<Protocol, String> {
-    use std::collections::{HashMap, HashSet};
-
-    let mut sorted_definitions = Vec::new();
-    let mut visited = HashSet::new();
-    let mut temp_mark = HashSet::new();
-
-    fn visit(
-        def: &Definition,
-        visited: &mut HashSet<String>,
-        temp_mark: &mut HashSet<String>,
-        sorted_definitions: &mut Vec<Definition>,
-        definitions_map: &HashMap<String, Definition>,
-    ) -> Result<(), String> {
-        let name = match def {
-            Definition::Enumeration(enumeration_def) => enumeration_def.name.name.clone(),
-            Definition::Structure(structure_def) => structure_def.name.name.clone(),
-            Definition::Union(union_def) => union_def.name.name.clone(),
-            Definition::Type(type_def) => type_def.new_type.name.clone(),
-        };
-
-        if temp_mark.contains(&name) {
-            return Err(format!("Circular dependency detected for {name}"));
-        }
-        if visited.contains(&name) {
-            return Ok(());
-        }
-
-        temp_mark.insert(name.clone());
-
-        match def {
-            Definition::Enumeration(_) => {}
-            Definition::Structure(structure_def) => {
-                for subtype in extract_structure_subtypes(structure_def) {
-                    if let Some(subtype_def) = definitions_map.get(&subtype) {
-                        visit(
-                            subtype_def,
-                            visited,
-                            temp_mark,
-                            sorted_definitions,
-                            definitions_map,
-                        )?;
-                    }
-                }
-            }
-            Definition::Union(union_def) => {
-                for subtype in extract_union_subtypes(union_def) {
-                    if let Some(subtype_def) = definitions_map.get(&subtype) {
-                        visit(
-                            subtype_def,
-                            visited,
-                            temp_mark,
-                            sorted_definitions,
-                            definitions_map,
-                        )?;
-                    }
-                }
-            }
-            Definition::Type(type_def) => {
-                if let Some(type_name) = extract_custom_type_identifier_name(&type_def.r#type)
-                    && let Some(type_def_ref) = definitions_map.get(&type_name)
-                {
-                    visit(
-                        type_def_ref,
-                        visited,
-                        temp_mark,
-                        sorted_definitions,
-                        definitions_map,
-                    )?;
-                }
-            }
-        }
-
-        temp_mark.remove(&name);
-        visited.insert(name.clone());
-        sorted_definitions.push(def.clone());
-
-        Ok(())
-    }
-
-    let definitions_map: HashMap<String, Definition> = protocol
-        .definitions
-        .iter()
-        .cloned()
-        .map(|def| match def {
-            Definition::Enumeration(enumeration_def) => (
-                enumeration_def.name.name.clone(),
-                Definition::Enumeration(enumeration_def),
-            ),
-            Definition::Structure(structure_def) => (
-                structure_def.name.name.clone(),
-                Definition::Structure(structure_def),
-            ),
-            Definition::Union(union_def) => {
-                (union_def.name.name.clone(), Definition::Union(union_def))
-            }
-            Definition::Type(type_def) => {
-                (type_def.new_type.name.clone(), Definition::Type(type_def))
-            }
-        })
-        .collect();
-
-    for def in &protocol.definitions {
-        let name = match def {
-            Definition::Enumeration(enumeration_def) => enumeration_def.name.name.clone(),
-            Definition::Structure(structure_def) => structure_def.name.name.clone(),
-            Definition::Union(union_def) => union_def.name.name.clone(),
-            Definition::Type(type_def) => type_def.new_type.name.clone(),
-        };
-        if !visited.contains(&name) {
-            visit(
-                def,
-                &mut visited,
-                &mut temp_mark,
-                &mut sorted_definitions,
-                &definitions_map,
-            )?;
-        }
-    }
-
+    let order = crate::graph::DependencyGraph::new(protocol).topological_order()?;
     Ok(Protocol {
-        definitions: sorted_definitions,
+        imports: protocol.imports.clone(),
+        definitions: order
+            .into_iter()
+            .map(|index| protocol.definitions[index].clone())
+            .collect(),
     })
 }
 
@@ -310,7 +212,7 @@ mod tests {
         let type_id = TypeIdentifier::UserDefined(Identifier::new("CustomType"));
         assert_eq!(
             extract_custom_type_identifier_name(&type_id),
-            Some("CustomType".to_string())
+            Some(InternedString::new("CustomType"))
         );
     }
 
@@ -322,7 +224,7 @@ mod tests {
         };
         assert_eq!(
             extract_custom_type_identifier_name(&type_id),
-            Some("CustomType".to_string())
+            Some(InternedString::new("CustomType"))
         );
     }
 
@@ -333,7 +235,7 @@ mod tests {
         };
         assert_eq!(
             extract_custom_type_identifier_name(&type_id),
-            Some("CustomType".to_string())
+            Some(InternedString::new("CustomType"))
         );
     }
 
@@ -477,6 +379,9 @@ struct B {
         let sorted = sort_protocol_by_dependencies(&parsed);
 
         assert!(sorted.is_err(), "Failed to detect circular dependency");
-        assert_eq!(sorted.err().unwrap(), "Circular dependency detected for A");
+        assert_eq!(
+            sorted.err().unwrap(),
+            "Circular dependency detected: A -> B -> A"
+        );
     }
 }
@@ -0,0 +1,435 @@
+//! On-disk binary cache for parsed [`Protocol`]s.
+//!
+//! [`parse_protocol_from_file_to_ast`] stores the AST of a file next to the
+//! source as `<file>.mekast`, keyed by a hash of the source text. When the
+//! source has not changed, the AST is decoded straight from the compact
+//! binary format and chumsky is skipped entirely. The format is a flat,
+//! tag-prefixed byte stream (fixed-width little-endian integers, length-
+//! prefixed strings) decoded in a single forward pass over the file bytes.
+//!
+//! Any mismatch — missing file, stale hash, wrong version, truncated or
+//! corrupted data — is treated as a cache miss and silently falls back to
+//! parsing, so the cache can never produce a worse result than no cache.
+//!
+//! [`parse_protocol_from_file_to_ast`]: crate::parse_protocol_from_file_to_ast
+
+use crate::ast::{
+    Attribute, Definition, EnumerationDefinition, EnumerationField, Identifier, Protocol,
+    StructureDefinition, StructureField, TypeDefinition, TypeIdentifier, UnionDefinition,
+    UnionField,
+};
+
+/// Magic bytes identifying the cache format; the trailing digits are the
+/// format version and must be bumped on any layout change.
+const MAGIC: &[u8; 8] = b"MEKAST02";
+
+/// Returns the cache path for a source file: the source path with `.mekast`
+/// appended, so the cache lives next to the file it belongs to.
+pub(crate) fn cache_path(file_path: &str) -> String {
+    format!("{file_path}.mekast")
+}
+
+/// Hashes content with FNV-1a, the key deciding cache validity.
+pub(crate) fn content_hash(input: &[u8]) -> u64 {
+    let mut hash: u64 = 0xcbf29ce484222325;
+    for &byte in input {
+        hash ^= u64::from(byte);
+        hash = hash.wrapping_mul(0x100000001b3);
+    }
+    hash
+}
+
+/// Loads the cached protocol for a source file, or `None` on any mismatch.
+pub(crate) fn load(file_path: &str, input: &str) -> Option<Protocol> {
+    let bytes = std::fs::read(cache_path(file_path)).ok()?;
+    let mut reader = Reader { bytes: &bytes };
+
+    if reader.take(MAGIC.len())? != MAGIC {
+        return None;
+    }
+    if reader.read_u64()? != content_hash(input.as_bytes()) {
+        return None;
+    }
+    let protocol = read_protocol(&mut reader)?;
+    reader.bytes.is_empty().then_some(protocol)
+}
+
+/// Stores the protocol for a source file. Failures are ignored: a cache that
+/// cannot be written only costs the next call a re-parse.
+pub(crate) fn store(file_path: &str, input: &str, protocol: &Protocol) {
+    let mut bytes = Vec::new();
+    bytes.extend_from_slice(MAGIC);
+    bytes.extend_from_slice(&content_hash(input.as_bytes()).to_le_bytes());
+    write_protocol(&mut bytes, protocol);
+    let _ = std::fs::write(cache_path(file_path), bytes);
+}
+
+/// A forward-only cursor over the cache bytes. Every read checks the
+/// remaining length, so truncated files simply decode to `None`.
+struct Reader<'bytes> {
+    bytes: &'bytes [u8],
+}
+
+impl<'bytes> Reader<'bytes> {
+    fn take(&mut self, count: usize) -> Option<&'bytes [u8]> {
+        let (taken, rest) = self.bytes.split_at_checked(count)?;
+        self.bytes = rest;
+        Some(taken)
+    }
+
+    fn read_u8(&mut self) -> Option<u8> {
+        Some(self.take(1)?[0])
+    }
+
+    fn read_u64(&mut self) -> Option<u64> {
+        Some(u64::from_le_bytes(self.take(8)?.try_into().ok()?))
+    }
+
+    fn read_string(&mut self) -> Option<&'bytes str> {
+        let length = usize::try_from(self.read_u64()?).ok()?;
+        std::str::from_utf8(self.take(length)?).ok()
+    }
+}
+
+fn write_string(bytes: &mut Vec<u8>, text: &str) {
+    bytes.extend_from_slice(&(text.len() as u64).to_le_bytes());
+    bytes.extend_from_slice(text.as_bytes());
+}
+
+fn write_identifier(bytes: &mut Vec<u8>, identifier: &Identifier) {
+    write_string(bytes, &identifier.name);
+}
+
+fn read_identifier(reader: &mut Reader) -> Option<Identifier> {
+    Some(Identifier::new(reader.read_string()?))
+}
+
+fn write_type_identifier(bytes: &mut Vec<u8>, r#type: &TypeIdentifier) {
+    match r#type {
+        TypeIdentifier::Integer8 => bytes.push(0),
+        TypeIdentifier::Integer16 => bytes.push(1),
+        TypeIdentifier::Integer32 => bytes.push(2),
+        TypeIdentifier::Integer64 => bytes.push(3),
+        TypeIdentifier::UnsignedInteger8 => bytes.push(4),
+        TypeIdentifier::UnsignedInteger16 => bytes.push(5),
+        TypeIdentifier::UnsignedInteger32 => bytes.push(6),
+        TypeIdentifier::UnsignedInteger64 => bytes.push(7),
+        TypeIdentifier::Float32 => bytes.push(8),
+        TypeIdentifier::Float64 => bytes.push(9),
+        TypeIdentifier::Bit => bytes.push(10),
+        TypeIdentifier::Byte => bytes.push(11),
+        TypeIdentifier::UserDefined(id) => {
+            bytes.push(12);
+            write_identifier(bytes, id);
+        }
+        TypeIdentifier::StaticArray { r#type, size } => {
+            bytes.push(13);
+            write_type_identifier(bytes, r#type);
+            bytes.extend_from_slice(&size.to_le_bytes());
+        }
+        TypeIdentifier::DynamicArray { r#type } => {
+            bytes.push(14);
+            write_type_identifier(bytes, r#type);
+        }
+    }
+}
+
+fn read_type_identifier(reader: &mut Reader) -> Option<TypeIdentifier> {
+    Some(match reader.read_u8()? {
+        0 => TypeIdentifier::Integer8,
+        1 => TypeIdentifier::Integer16,
+        2 => TypeIdentifier::Integer32,
+        3 => TypeIdentifier::Integer64,
+        4 => TypeIdentifier::UnsignedInteger8,
+        5 => TypeIdentifier::UnsignedInteger16,
+        6 => TypeIdentifier::UnsignedInteger32,
+        7 => TypeIdentifier::UnsignedInteger64,
+        8 => TypeIdentifier::Float32,
+        9 => TypeIdentifier::Float64,
+        10 => TypeIdentifier::Bit,
+        11 => TypeIdentifier::Byte,
+        12 => TypeIdentifier::UserDefined(read_identifier(reader)?),
+        13 => TypeIdentifier::StaticArray {
+            r#type: Box::new(read_type_identifier(reader)?),
+            size: reader.read_u64()?,
+        },
+        14 => TypeIdentifier::DynamicArray {
+            r#type: Box::new(read_type_identifier(reader)?),
+        },
+        _ => return None,
+    })
+}
+
+fn write_attribute(bytes: &mut Vec<u8>, attribute: &Attribute) {
+    match attribute {
+        Attribute::DiscriminatedBy { field } => {
+            bytes.push(0);
+            write_identifier(bytes, field);
+        }
+        Attribute::BitsSize { size } => {
+            bytes.push(1);
+            bytes.extend_from_slice(&size.to_le_bytes());
+        }
+        Attribute::BytesSize { size } => {
+            bytes.push(2);
+            bytes.extend_from_slice(&size.to_le_bytes());
+        }
+    }
+}
+
+fn read_attribute(reader: &mut Reader) -> Option<Attribute> {
+    Some(match reader.read_u8()? {
+        0 => Attribute::DiscriminatedBy {
+            field: read_identifier(reader)?,
+        },
+        1 => Attribute::BitsSize {
+            size: reader.read_u64()?,
+        },
+        2 => Attribute::BytesSize {
+            size: reader.read_u64()?,
+        },
+        _ => return None,
+    })
+}
+
+pub(crate) fn write_definition(bytes: &mut Vec<u8>, definition: &Definition) {
+    match definition {
+        Definition::Enumeration(enumeration_def) => {
+            bytes.push(0);
+            write_identifier(bytes, &enumeration_def.name);
+            bytes.extend_from_slice(&(enumeration_def.fields.len() as u64).to_le_bytes());
+            for field in &enumeration_def.fields {
+                match field {
+                    EnumerationField::SingleValue { name, value } => {
+                        bytes.push(0);
+                        write_identifier(bytes, name);
+                        bytes.extend_from_slice(&value.to_le_bytes());
+                    }
+                    EnumerationField::RangeOfValues { name, start, end } => {
+                        bytes.push(1);
+                        write_identifier(bytes, name);
+                        bytes.extend_from_slice(&start.to_le_bytes());
+                        bytes.extend_from_slice(&end.to_le_bytes());
+                    }
+                }
+            }
+        }
+        Definition::Structure(structure_def) => {
+            bytes.push(1);
+            write_identifier(bytes, &structure_def.name);
+            bytes.extend_from_slice(&(structure_def.fields.len() as u64).to_le_bytes());
+            for field in &structure_def.fields {
+                write_identifier(bytes, &field.name);
+                write_type_identifier(bytes, &field.r#type);
+                bytes.extend_from_slice(&(field.attributes.len() as u64).to_le_bytes());
+                for attribute in &field.attributes {
+                    write_attribute(bytes, attribute);
+                }
+            }
+        }
+        Definition::Union(union_def) => {
+            bytes.push(2);
+            write_identifier(bytes, &union_def.name);
+            bytes.extend_from_slice(&(union_def.fields.len() as u64).to_le_bytes());
+            for field in &union_def.fields {
+                match field {
+                    UnionField::SingleValue {
+                        name,
+                        r#type,
+                        discriminator,
+                    } => {
+                        bytes.push(0);
+                        write_identifier(bytes, name);
+                        write_type_identifier(bytes, r#type);
+                        bytes.extend_from_slice(&discriminator.to_le_bytes());
+                    }
+                    UnionField::RangeOfValues {
+                        name,
+                        r#type,
+                        start_discriminator,
+                        end_discriminator,
+                    } => {
+                        bytes.push(1);
+                        write_identifier(bytes, name);
+                        write_type_identifier(bytes, r#type);
+                        bytes.extend_from_slice(&start_discriminator.to_le_bytes());
+                        bytes.extend_from_slice(&end_discriminator.to_le_bytes());
+                    }
+                }
+            }
+        }
+        Definition::Type(type_def) => {
+            bytes.push(3);
+            write_identifier(bytes, &type_def.new_type);
+            write_type_identifier(bytes, &type_def.r#type);
+        }
+    }
+}
+
+fn read_definition(reader: &mut Reader) -> Option<Definition> {
+    Some(match reader.read_u8()? {
+        0 => {
+            let name = read_identifier(reader)?;
+            let count = usize::try_from(reader.read_u64()?).ok()?;
+            let mut fields = Vec::with_capacity(count.min(reader.bytes.len()));
+            for _ in 0..count {
+                fields.push(match reader.read_u8()? {
+                    0 => EnumerationField::SingleValue {
+                        name: read_identifier(reader)?,
+                        value: reader.read_u64()?,
+                    },
+                    1 => EnumerationField::RangeOfValues {
+                        name: read_identifier(reader)?,
+                        start: reader.read_u64()?,
+                        end: reader.read_u64()?,
+                    },
+                    _ => return None,
+                });
+            }
+            Definition::Enumeration(EnumerationDefinition { name, fields })
+        }
+        1 => {
+            let name = read_identifier(reader)?;
+            let count = usize::try_from(reader.read_u64()?).ok()?;
+            let mut fields = Vec::with_capacity(count.min(reader.bytes.len()));
+            for _ in 0..count {
+                let name = read_identifier(reader)?;
+                let r#type = read_type_identifier(reader)?;
+                let attribute_count = usize::try_from(reader.read_u64()?).ok()?;
+                let mut attributes = Vec::with_capacity(attribute_count.min(reader.bytes.len()));
+                for _ in 0..attribute_count {
+                    attributes.push(read_attribute(reader)?);
+                }
+                fields.push(StructureField {
+                    name,
+                    r#type,
+                    attributes,
+                });
+            }
+            Definition::Structure(StructureDefinition { name, fields })
+        }
+        2 => {
+            let name = read_identifier(reader)?;
+            let count = usize::try_from(reader.read_u64()?).ok()?;
+            let mut fields = Vec::with_capacity(count.min(reader.bytes.len()));
+            for _ in 0..count {
+                fields.push(match reader.read_u8()? {
+                    0 => UnionField::SingleValue {
+                        name: read_identifier(reader)?,
+                        r#type: read_type_identifier(reader)?,
+                        discriminator: reader.read_u64()?,
+                    },
+                    1 => UnionField::RangeOfValues {
+                        name: read_identifier(reader)?,
+                        r#type: read_type_identifier(reader)?,
+                        start_discriminator: reader.read_u64()?,
+                        end_discriminator: reader.read_u64()?,
+                    },
+                    _ => return None,
+                });
+            }
+            Definition::Union(UnionDefinition { name, fields })
+        }
+        3 => Definition::Type(TypeDefinition {
+            new_type: read_identifier(reader)?,
+            r#type: read_type_identifier(reader)?,
+        }),
+        _ => return None,
+    })
+}
+
+fn write_protocol(bytes: &mut Vec<u8>, protocol: &Protocol) {
+    bytes.extend_from_slice(&(protocol.imports.len() as u64).to_le_bytes());
+    for import in &protocol.imports {
+        write_string(bytes, import);
+    }
+    bytes.extend_from_slice(&(protocol.definitions.len() as u64).to_le_bytes());
+    for definition in &protocol.definitions {
+        write_definition(bytes, definition);
+    }
+}
+
+fn read_protocol(reader: &mut Reader) -> Option<Protocol> {
+    let import_count = usize::try_from(reader.read_u64()?).ok()?;
+    let mut imports = Vec::with_capacity(import_count.min(reader.bytes.len()));
+    for _ in 0..import_count {
+        imports.push(reader.read_string()?.to_string());
+    }
+    let count = usize::try_from(reader.read_u64()?).ok()?;
+    let mut definitions = Vec::with_capacity(count.min(reader.bytes.len()));
+    for _ in 0..count {
+        definitions.push(read_definition(reader)?);
+    }
+    Some(Protocol {
+        imports,
+        definitions,
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::parse_protocol_to_ast;
+
+    static SOURCE: &str = "using FilePath = byte[100];\nenum LogLevel {\n    debug = 0;\n    spare = 1..7;\n};\nstruct Log {\n    level: LogLevel;\n    [discriminated_by = level, bits = 4] detail: uint8;\n    message: byte[];\n};\nunion Payload {\n    0 => log: Log;\n    1..255 => raw: byte[];\n};\n";
+
+    #[test]
+    fn test_roundtrip_preserves_protocol() {
+        let protocol = parse_protocol_to_ast(SOURCE).expect("Parsing failed");
+        let mut bytes = Vec::new();
+        write_protocol(&mut bytes, &protocol);
+        let decoded = read_protocol(&mut Reader { bytes: &bytes }).expect("Decoding failed");
+        assert_eq!(decoded, protocol);
+    }
+
+    #[test]
+    fn test_load_returns_stored_protocol() {
+        let directory = tempfile::tempdir().expect("Failed to create temp dir");
+        let file_path = directory.path().join("protocol.mek");
+        let file_path = file_path.to_str().unwrap();
+
+        let protocol = parse_protocol_to_ast(SOURCE).expect("Parsing failed");
+        store(file_path, SOURCE, &protocol);
+        assert_eq!(load(file_path, SOURCE), Some(protocol));
+    }
+
+    #[test]
+    fn test_load_misses_when_source_changed() {
+        let directory = tempfile::tempdir().expect("Failed to create temp dir");
+        let file_path = directory.path().join("protocol.mek");
+        let file_path = file_path.to_str().unwrap();
+
+        let protocol = parse_protocol_to_ast(SOURCE).expect("Parsing failed");
+        store(file_path, SOURCE, &protocol);
+        assert_eq!(load(file_path, "using Other = uint8;\n"), None);
+    }
+
+    #[test]
+    fn test_load_misses_on_corrupted_cache() {
+        let directory = tempfile::tempdir().expect("Failed to create temp dir");
+        let file_path = directory.path().join("protocol.mek");
+        let file_path = file_path.to_str().unwrap();
+
+        let protocol = parse_protocol_to_ast(SOURCE).expect("Parsing failed");
+        store(file_path, SOURCE, &protocol);
+
+        let mut bytes = std::fs::read(cache_path(file_path)).expect("Failed to read cache");
+        bytes.truncate(bytes.len() - 1);
+        std::fs::write(cache_path(file_path), bytes).expect("Failed to write cache");
+        assert_eq!(load(file_path, SOURCE), None);
+    }
+
+    #[test]
+    fn test_load_misses_without_cache_file() {
+        assert_eq!(load("does_not_exist.mek", SOURCE), None);
+    }
+
+    #[test]
+    fn test_content_hash_is_stable_and_distinguishes_inputs() {
+        assert_eq!(
+            content_hash(SOURCE.as_bytes()),
+            content_hash(SOURCE.as_bytes())
+        );
+        assert_ne!(content_hash(SOURCE.as_bytes()), content_hash(b"other"));
+    }
+}
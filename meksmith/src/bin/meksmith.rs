@@ -0,0 +1,251 @@
+//! Batch compiler for meklang protocol files.
+//!
+//! Expands the given patterns, generates C next to each input (extension
+//! replaced by `.h`) through [`meksmith::smith_c::generate_from_file_to_file`],
+//! and schedules the files across rayon's work-stealing thread pool, so a
+//! whole protocol tree compiles in one warm process instead of one process
+//! per file. With `--watch` the process stays alive and re-generates only
+//! files whose content hash changed.
+//!
+//! Usage: `meksmith [--watch] [--out-dir DIR] <file-or-glob>...`
+
+use rayon::prelude::*;
+
+use std::collections::HashMap;
+use std::path::{Path, PathBuf};
+
+/// Polling interval of the watch loop.
+const WATCH_INTERVAL: std::time::Duration = std::time::Duration::from_millis(500);
+
+fn main() {
+    let arguments: Vec<String> = std::env::args().skip(1).collect();
+    let mut watch = false;
+    let mut out_dir: Option<PathBuf> = None;
+    let mut patterns = Vec::new();
+
+    let mut iterator = arguments.into_iter();
+    while let Some(argument) = iterator.next() {
+        match argument.as_str() {
+            "--watch" => watch = true,
+            "--out-dir" => match iterator.next() {
+                Some(directory) => out_dir = Some(PathBuf::from(directory)),
+                None => exit_with_usage("--out-dir requires a directory argument"),
+            },
+            "--help" | "-h" => exit_with_usage(""),
+            _ if argument.starts_with("--") => {
+                exit_with_usage(&format!("Unknown option {argument}"))
+            }
+            _ => patterns.push(argument),
+        }
+    }
+    if patterns.is_empty() {
+        exit_with_usage("No input files given");
+    }
+
+    let mut hashes: HashMap<PathBuf, u64> = HashMap::new();
+    let failed = generate_changed(&patterns, out_dir.as_deref(), &mut hashes);
+
+    if !watch {
+        std::process::exit(if failed { 1 } else { 0 });
+    }
+    loop {
+        std::thread::sleep(WATCH_INTERVAL);
+        // Failures are already reported per file; the watch loop keeps
+        // running so the next save can fix them.
+        let _ = generate_changed(&patterns, out_dir.as_deref(), &mut hashes);
+    }
+}
+
+fn exit_with_usage(error: &str) -> ! {
+    if !error.is_empty() {
+        eprintln!("{error}");
+    }
+    eprintln!("Usage: meksmith [--watch] [--out-dir DIR] <file-or-glob>...");
+    std::process::exit(if error.is_empty() { 0 } else { 2 });
+}
+
+/// Expands the patterns, generates every file whose content hash differs
+/// from the last pass in parallel, and updates the hashes. Returns `true`
+/// when at least one file failed.
+fn generate_changed(
+    patterns: &[String],
+    out_dir: Option<&Path>,
+    hashes: &mut HashMap<PathBuf, u64>,
+) -> bool {
+    let mut changed = Vec::new();
+    for path in patterns.iter().flat_map(|pattern| expand_pattern(pattern)) {
+        let Ok(content) = std::fs::read_to_string(&path) else {
+            eprintln!("{}: failed to read file", path.display());
+            continue;
+        };
+        let hash = content_hash(&content);
+        if hashes.get(&path) != Some(&hash) {
+            changed.push((path, hash));
+        }
+    }
+
+    let results: Vec<(
+        PathBuf,
+        u64,
+        Result<meksmith::smith_c::WriteOutcome, String>,
+    )> = changed
+        .into_par_iter()
+        .map(|(path, hash)| {
+            let output = output_path(&path, out_dir);
+            let result = meksmith::smith_c::generate_from_file_to_file(
+                path.to_str().unwrap_or_default(),
+                output.to_str().unwrap_or_default(),
+            );
+            (path, hash, result)
+        })
+        .collect();
+
+    let mut failed = false;
+    for (path, hash, result) in results {
+        match result {
+            Ok(outcome) => {
+                match outcome {
+                    meksmith::smith_c::WriteOutcome::Written => {
+                        println!("{}: generated", path.display())
+                    }
+                    meksmith::smith_c::WriteOutcome::Unchanged => {
+                        println!("{}: up to date", path.display())
+                    }
+                }
+                hashes.insert(path, hash);
+            }
+            Err(error) => {
+                eprintln!("{}: {error}", path.display());
+                hashes.remove(&path);
+                failed = true;
+            }
+        }
+    }
+    failed
+}
+
+/// Returns the output path for an input file: the input with its extension
+/// replaced by `.h`, placed in `out_dir` when given.
+fn output_path(input: &Path, out_dir: Option<&Path>) -> PathBuf {
+    let output = input.with_extension("h");
+    match out_dir {
+        Some(directory) => directory.join(output.file_name().unwrap_or_default()),
+        None => output,
+    }
+}
+
+/// Expands a pattern into matching file paths. Literal paths are returned
+/// as-is; a `*` matches within one path component of the pattern's
+/// directory, so shells without glob expansion still work.
+fn expand_pattern(pattern: &str) -> Vec<PathBuf> {
+    if !pattern.contains('*') {
+        return vec![PathBuf::from(pattern)];
+    }
+
+    let path = Path::new(pattern);
+    let directory = match path.parent() {
+        Some(parent) if parent != Path::new("") => parent.to_path_buf(),
+        _ => PathBuf::from("."),
+    };
+    let file_pattern = path
+        .file_name()
+        .map(|name| name.to_string_lossy().into_owned())
+        .unwrap_or_default();
+
+    let Ok(entries) = std::fs::read_dir(&directory) else {
+        return Vec::new();
+    };
+    let mut matches: Vec<PathBuf> = entries
+        .flatten()
+        .filter(|entry| matches_pattern(&entry.file_name().to_string_lossy(), &file_pattern))
+        .map(|entry| entry.path())
+        .collect();
+    matches.sort();
+    matches
+}
+
+/// Matches a file name against a pattern where `*` matches any (possibly
+/// empty) sequence of characters.
+fn matches_pattern(name: &str, pattern: &str) -> bool {
+    let mut parts = pattern.split('*');
+    let first = parts.next().unwrap_or_default();
+    if !name.starts_with(first) {
+        return false;
+    }
+
+    let mut remaining = &name[first.len()..];
+    let mut parts = parts.peekable();
+    while let Some(part) = parts.next() {
+        if parts.peek().is_none() {
+            return remaining.ends_with(part);
+        }
+        match remaining.find(part) {
+            Some(position) => remaining = &remaining[position + part.len()..],
+            None => return false,
+        }
+    }
+    true
+}
+
+/// Hashes a file's content with FNV-1a to detect changes between passes.
+fn content_hash(input: &str) -> u64 {
+    let mut hash: u64 = 0xcbf29ce484222325;
+    for byte in input.bytes() {
+        hash ^= u64::from(byte);
+        hash = hash.wrapping_mul(0x100000001b3);
+    }
+    hash
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_matches_pattern() {
+        assert!(matches_pattern("protocol.mek", "*.mek"));
+        assert!(matches_pattern("protocol.mek", "proto*"));
+        assert!(matches_pattern("protocol.mek", "p*l.mek"));
+        assert!(matches_pattern("protocol.mek", "*"));
+        assert!(!matches_pattern("protocol.mek", "*.txt"));
+        assert!(!matches_pattern("protocol.mek", "q*"));
+    }
+
+    #[test]
+    fn test_output_path() {
+        assert_eq!(
+            output_path(Path::new("protocols/log.mek"), None),
+            PathBuf::from("protocols/log.h")
+        );
+        assert_eq!(
+            output_path(Path::new("protocols/log.mek"), Some(Path::new("out"))),
+            PathBuf::from("out/log.h")
+        );
+    }
+
+    #[test]
+    fn test_expand_pattern_without_glob_is_literal() {
+        assert_eq!(
+            expand_pattern("missing/file.mek"),
+            vec![PathBuf::from("missing/file.mek")]
+        );
+    }
+
+    #[test]
+    fn test_generate_changed_skips_unchanged_files() {
+        let directory = tempfile::tempdir().expect("Failed to create temp dir");
+        let input = directory.path().join("protocol.mek");
+        std::fs::write(&input, "using MyType = int32;\n").expect("Failed to write input");
+
+        let patterns = vec![input.to_str().unwrap().to_string()];
+        let mut hashes = HashMap::new();
+        assert!(!generate_changed(&patterns, None, &mut hashes));
+        assert!(directory.path().join("protocol.h").exists());
+        assert_eq!(hashes.len(), 1);
+
+        // An unchanged file is not re-generated: its hash stays in the map
+        // and the pass reports no failures.
+        assert!(!generate_changed(&patterns, None, &mut hashes));
+        assert_eq!(hashes.len(), 1);
+    }
+}
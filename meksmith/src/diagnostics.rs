@@ -0,0 +1,132 @@
+//! Structured parse diagnostics and the line index used to locate them.
+//!
+//! Error positions are resolved through a [`LineIndex`] built once per parse:
+//! a binary-searchable table of line start offsets, so mapping a byte offset
+//! to a line and column is O(log lines) instead of a scan over the whole
+//! source per error.
+
+use std::ops::Range;
+
+/// A single parse error with its position in the source. The span is in byte
+/// offsets; line and column are 1-based.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct Diagnostic {
+    pub span: Range<usize>,
+    pub line: usize,
+    pub column: usize,
+    pub message: String,
+}
+
+impl std::fmt::Display for Diagnostic {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        write!(f, "{} in {}:{}", self.message, self.line, self.column)
+    }
+}
+
+/// Joins diagnostics into the single-string error format used by the
+/// string-returning entry points.
+pub(crate) fn join_diagnostics(diagnostics: &[Diagnostic]) -> String {
+    let messages: Vec<String> = diagnostics
+        .iter()
+        .map(|diagnostic| diagnostic.to_string())
+        .collect();
+    format!("Parsing failed. Errors: {}", messages.join(", "))
+}
+
+/// A table of line start offsets for a source, allowing byte offsets to be
+/// mapped to line and column positions by binary search.
+#[derive(Debug, Clone)]
+pub struct LineIndex {
+    line_starts: Vec<usize>,
+}
+
+impl LineIndex {
+    /// Builds the index by recording the start offset of every line.
+    pub fn new(source: &str) -> Self {
+        let mut line_starts = vec![0];
+        line_starts.extend(
+            source
+                .bytes()
+                .enumerate()
+                .filter(|(_, byte)| *byte == b'\n')
+                .map(|(offset, _)| offset + 1),
+        );
+        LineIndex { line_starts }
+    }
+
+    /// Returns the 1-based line and column of a byte offset.
+    pub fn location(&self, offset: usize) -> (usize, usize) {
+        let line = self
+            .line_starts
+            .partition_point(|start| *start <= offset)
+            .saturating_sub(1);
+        (line + 1, offset - self.line_starts[line] + 1)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_line_index_single_line() {
+        let index = LineIndex::new("using MyType = int32;");
+        assert_eq!(index.location(0), (1, 1));
+        assert_eq!(index.location(6), (1, 7));
+    }
+
+    #[test]
+    fn test_line_index_multiple_lines() {
+        let index = LineIndex::new("first\nsecond\nthird\n");
+        assert_eq!(index.location(0), (1, 1));
+        assert_eq!(index.location(5), (1, 6));
+        assert_eq!(index.location(6), (2, 1));
+        assert_eq!(index.location(12), (2, 7));
+        assert_eq!(index.location(13), (3, 1));
+    }
+
+    #[test]
+    fn test_line_index_offset_past_end() {
+        let index = LineIndex::new("first\nsecond");
+        assert_eq!(index.location(100), (2, 95));
+    }
+
+    #[test]
+    fn test_line_index_empty_source() {
+        let index = LineIndex::new("");
+        assert_eq!(index.location(0), (1, 1));
+    }
+
+    #[test]
+    fn test_diagnostic_display() {
+        let diagnostic = Diagnostic {
+            span: 10..11,
+            line: 2,
+            column: 5,
+            message: "found ';' expected digit".to_string(),
+        };
+        assert_eq!(diagnostic.to_string(), "found ';' expected digit in 2:5");
+    }
+
+    #[test]
+    fn test_join_diagnostics() {
+        let diagnostics = vec![
+            Diagnostic {
+                span: 0..1,
+                line: 1,
+                column: 1,
+                message: "first error".to_string(),
+            },
+            Diagnostic {
+                span: 5..6,
+                line: 1,
+                column: 6,
+                message: "second error".to_string(),
+            },
+        ];
+        assert_eq!(
+            join_diagnostics(&diagnostics),
+            "Parsing failed. Errors: first error in 1:1, second error in 1:6"
+        );
+    }
+}
@@ -0,0 +1,227 @@
+//! Type-reference graph over a protocol's definitions.
+//!
+//! [`DependencyGraph::new`] builds the graph in a single pass: one node per
+//! entry of `Protocol::definitions`, one edge per user-defined type
+//! reference, resolved through a name index built the same way as
+//! [`SymbolTable`](crate::symbols::SymbolTable). The graph backs
+//! `sort_protocol_by_dependencies`,
+//! reports cycles with the full reference chain, and exposes the independent
+//! components so a scheduler can hand disconnected subgraphs to separate
+//! workers. The per-definition parallel smith already treats every definition
+//! as independent — concatenation order is fixed by the topological sort, not
+//! by generation order — so the components are for coarser schedulers, such
+//! as splitting output across files.
+
+use crate::ast::{
+    Definition, Protocol, extract_custom_type_identifier_name, extract_structure_subtypes,
+    extract_union_subtypes,
+};
+use crate::intern::InternedString;
+use crate::symbols::definition_name;
+
+use std::collections::HashMap;
+
+/// How far a depth-first traversal has gotten with a node.
+#[derive(Clone, Copy, PartialEq)]
+enum VisitState {
+    Unvisited,
+    /// On the current traversal path; reaching it again closes a cycle.
+    InProgress,
+    Done,
+}
+
+/// The type-reference graph of a protocol: which definitions each definition
+/// depends on, by index into `Protocol::definitions`. References to names
+/// without a definition (a semantic error caught by
+/// [`check_protocol`](crate::symbols::check_protocol)) simply have no edge.
+#[derive(Debug)]
+pub struct DependencyGraph<'protocol> {
+    protocol: &'protocol Protocol,
+    /// `dependencies[i]` holds the indices of the definitions that
+    /// `protocol.definitions[i]` references, in field order.
+    dependencies: Vec<Vec<usize>>,
+}
+
+impl<'protocol> DependencyGraph<'protocol> {
+    /// Builds the graph in one pass over the definitions. On duplicate
+    /// definition names the first definition wins, matching the symbol table.
+    pub fn new(protocol: &'protocol Protocol) -> Self {
+        let mut index_by_name = HashMap::with_capacity(protocol.definitions.len());
+        for (index, definition) in protocol.definitions.iter().enumerate() {
+            index_by_name
+                .entry(definition_name(definition))
+                .or_insert(index);
+        }
+
+        let resolve = |names: Vec<InternedString>| -> Vec<usize> {
+            names
+                .into_iter()
+                .filter_map(|name| index_by_name.get(&name).copied())
+                .collect()
+        };
+        let dependencies = protocol
+            .definitions
+            .iter()
+            .map(|definition| match definition {
+                Definition::Enumeration(_) => Vec::new(),
+                Definition::Structure(structure_def) => {
+                    resolve(extract_structure_subtypes(structure_def))
+                }
+                Definition::Union(union_def) => resolve(extract_union_subtypes(union_def)),
+                Definition::Type(type_def) => resolve(
+                    extract_custom_type_identifier_name(&type_def.r#type)
+                        .into_iter()
+                        .collect(),
+                ),
+            })
+            .collect();
+
+        DependencyGraph {
+            protocol,
+            dependencies,
+        }
+    }
+
+    /// Returns the indices of the definitions that definition `index`
+    /// references, in field order.
+    pub fn dependencies_of(&self, index: usize) -> &[usize] {
+        &self.dependencies[index]
+    }
+
+    /// Returns the definition indices in dependency order: every definition
+    /// comes after everything it references. Definitions without ordering
+    /// constraints keep their source order. On a cycle the error spells out
+    /// the whole reference chain, e.g. `A -> B -> A`.
+    pub fn topological_order(&self) -> Result<Vec<usize>, String> {
+        let mut state = vec![VisitState::Unvisited; self.dependencies.len()];
+        let mut order = Vec::with_capacity(self.dependencies.len());
+        let mut path = Vec::new();
+        for index in 0..self.dependencies.len() {
+            self.visit(index, &mut state, &mut order, &mut path)?;
+        }
+        Ok(order)
+    }
+
+    fn visit(
+        &self,
+        index: usize,
+        state: &mut [VisitState],
+        order: &mut Vec<usize>,
+        path: &mut Vec<usize>,
+    ) -> Result<(), String> {
+        match state[index] {
+            VisitState::Done => return Ok(()),
+            VisitState::InProgress => {
+                let closes_cycle = path.iter().position(|&i| i == index).unwrap_or(0);
+                let chain = path[closes_cycle..]
+                    .iter()
+                    .chain(std::iter::once(&index))
+                    .map(|&i| self.name_of(i))
+                    .collect::<Vec<_>>()
+                    .join(" -> ");
+                return Err(format!("Circular dependency detected: {chain}"));
+            }
+            VisitState::Unvisited => {}
+        }
+
+        state[index] = VisitState::InProgress;
+        path.push(index);
+        for &dependency in &self.dependencies[index] {
+            self.visit(dependency, state, order, path)?;
+        }
+        path.pop();
+        state[index] = VisitState::Done;
+        order.push(index);
+        Ok(())
+    }
+
+    /// Returns the weakly connected components of the graph — groups of
+    /// definitions with no references between groups — each in source order.
+    /// Components can be generated independently, in any order, on any worker.
+    pub fn independent_components(&self) -> Vec<Vec<usize>> {
+        let mut component_of = vec![usize::MAX; self.dependencies.len()];
+        let mut components: Vec<Vec<usize>> = Vec::new();
+
+        for start in 0..self.dependencies.len() {
+            if component_of[start] != usize::MAX {
+                continue;
+            }
+            let component = components.len();
+            let mut pending = vec![start];
+            while let Some(index) = pending.pop() {
+                if component_of[index] != usize::MAX {
+                    continue;
+                }
+                component_of[index] = component;
+                pending.extend_from_slice(&self.dependencies[index]);
+                // Edges are directed; walk them backwards too so a definition
+                // lands in the same component as everything referencing it.
+                pending.extend(
+                    (0..self.dependencies.len())
+                        .filter(|&other| self.dependencies[other].contains(&index)),
+                );
+            }
+            components.push(Vec::new());
+        }
+
+        for (index, &component) in component_of.iter().enumerate() {
+            components[component].push(index);
+        }
+        components
+    }
+
+    fn name_of(&self, index: usize) -> String {
+        definition_name(&self.protocol.definitions[index]).to_string()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::parse_protocol_to_ast;
+
+    static SOURCE: &str = "struct Outer {\n    inner: Inner;\n    level: Level;\n};\nstruct Inner {\n    value: uint8;\n};\nenum Level {\n    low = 0;\n    high = 1;\n};\nusing Standalone = uint32;\n";
+
+    #[test]
+    fn test_dependencies_resolve_to_definition_indices() {
+        let protocol = parse_protocol_to_ast(SOURCE).expect("Parsing failed");
+        let graph = DependencyGraph::new(&protocol);
+
+        // Outer (0) references Inner (1) and Level (2); the rest reference
+        // nothing.
+        assert_eq!(graph.dependencies_of(0), &[1, 2]);
+        assert_eq!(graph.dependencies_of(1), &[] as &[usize]);
+        assert_eq!(graph.dependencies_of(2), &[] as &[usize]);
+        assert_eq!(graph.dependencies_of(3), &[] as &[usize]);
+    }
+
+    #[test]
+    fn test_topological_order_puts_dependencies_first() {
+        let protocol = parse_protocol_to_ast(SOURCE).expect("Parsing failed");
+        let graph = DependencyGraph::new(&protocol);
+
+        assert_eq!(graph.topological_order(), Ok(vec![1, 2, 0, 3]));
+    }
+
+    #[test]
+    fn test_topological_order_reports_the_whole_cycle() {
+        let source = "struct A {\n    field: B;\n};\nstruct B {\n    field: C;\n};\nstruct C {\n    field: A;\n};\n";
+        let protocol = parse_protocol_to_ast(source).expect("Parsing failed");
+        let graph = DependencyGraph::new(&protocol);
+
+        assert_eq!(
+            graph.topological_order(),
+            Err("Circular dependency detected: A -> B -> C -> A".to_string())
+        );
+    }
+
+    #[test]
+    fn test_independent_components_split_unrelated_subgraphs() {
+        let protocol = parse_protocol_to_ast(SOURCE).expect("Parsing failed");
+        let graph = DependencyGraph::new(&protocol);
+
+        // Outer/Inner/Level hang together; Standalone references nothing and
+        // nothing references it.
+        assert_eq!(graph.independent_components(), vec![vec![0, 1, 2], vec![3]]);
+    }
+}
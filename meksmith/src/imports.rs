@@ -0,0 +1,184 @@
+//! Import resolution over a graph of meklang files.
+//!
+//! `import "path";` statements (paths are relative to the importing file) are
+//! resolved breadth-first: every wave of not-yet-parsed files is parsed on
+//! its own thread, and each file is parsed exactly once no matter how many
+//! times it is imported. The per-file work goes through
+//! [`parse_protocol_from_file_to_ast`], so it also benefits from the on-disk
+//! AST cache. The parsed graph is merged depth-first into a single
+//! [`Protocol`] with imported definitions placed before their importers.
+//!
+//! [`parse_protocol_from_file_to_ast`]: crate::parse_protocol_from_file_to_ast
+
+use crate::ast::{Definition, Protocol};
+
+use std::collections::{HashMap, HashSet};
+use std::path::{Path, PathBuf};
+
+/// Parses `file_path` and every file it transitively imports, returning one
+/// merged protocol. Files imported from several places are parsed and merged
+/// only once; files with no import relationship parse in parallel.
+pub fn parse_protocol_with_imports(file_path: &str) -> Result<Protocol, String> {
+    let root = resolve_path(Path::new("."), file_path)?;
+    let mut parsed: HashMap<PathBuf, Protocol> = HashMap::new();
+    let mut imports_of: HashMap<PathBuf, Vec<PathBuf>> = HashMap::new();
+
+    let mut wave = vec![root.clone()];
+    while !wave.is_empty() {
+        let results: Vec<(PathBuf, Result<Protocol, String>)> = std::thread::scope(|scope| {
+            let handles: Vec<_> = wave
+                .iter()
+                .map(|path| {
+                    scope.spawn(move || {
+                        let protocol = crate::parse_protocol_from_file_to_ast(
+                            path.to_str().unwrap_or_default(),
+                        );
+                        (path.clone(), protocol)
+                    })
+                })
+                .collect();
+            handles
+                .into_iter()
+                .map(|handle| handle.join().expect("Parsing thread panicked"))
+                .collect()
+        });
+
+        let mut next_wave: Vec<PathBuf> = Vec::new();
+        for (path, result) in results {
+            let protocol = result.map_err(|e| format!("{}: {e}", path.display()))?;
+            let directory = path.parent().unwrap_or(Path::new(".")).to_path_buf();
+
+            let mut children = Vec::new();
+            for import in &protocol.imports {
+                let child = resolve_path(&directory, import)
+                    .map_err(|e| format!("{}: {e}", path.display()))?;
+                if !parsed.contains_key(&child) && !next_wave.contains(&child) {
+                    next_wave.push(child.clone());
+                }
+                children.push(child);
+            }
+            imports_of.insert(path.clone(), children);
+            parsed.insert(path, protocol);
+        }
+        next_wave.retain(|path| !parsed.contains_key(path));
+        wave = next_wave;
+    }
+
+    let mut definitions = Vec::new();
+    let mut merged = HashSet::new();
+    merge(&root, &parsed, &imports_of, &mut merged, &mut definitions);
+    Ok(Protocol {
+        imports: Vec::new(),
+        definitions,
+    })
+}
+
+/// Resolves an import path relative to `directory` and canonicalizes it, so
+/// the same file reached through different paths dedupes to one entry.
+fn resolve_path(directory: &Path, import: &str) -> Result<PathBuf, String> {
+    directory
+        .join(import)
+        .canonicalize()
+        .map_err(|e| format!("Failed to resolve import {import}: {e}"))
+}
+
+/// Appends the definitions of `path` and everything it imports, imports
+/// first, visiting every file exactly once.
+fn merge(
+    path: &PathBuf,
+    parsed: &HashMap<PathBuf, Protocol>,
+    imports_of: &HashMap<PathBuf, Vec<PathBuf>>,
+    merged: &mut HashSet<PathBuf>,
+    definitions: &mut Vec<Definition>,
+) {
+    if !merged.insert(path.clone()) {
+        return;
+    }
+    for child in &imports_of[path] {
+        merge(child, parsed, imports_of, merged, definitions);
+    }
+    definitions.extend(parsed[path].definitions.iter().cloned());
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn write_file(directory: &Path, name: &str, contents: &str) -> String {
+        let path = directory.join(name);
+        std::fs::write(&path, contents).expect("Failed to write test file");
+        path.to_str().unwrap().to_string()
+    }
+
+    #[test]
+    fn test_diamond_import_is_merged_once() {
+        let directory = tempfile::tempdir().expect("Failed to create temp dir");
+        write_file(directory.path(), "common.mek", "using Shared = uint8;\n");
+        write_file(
+            directory.path(),
+            "left.mek",
+            "import \"common.mek\";\nusing Left = Shared[2];\n",
+        );
+        write_file(
+            directory.path(),
+            "right.mek",
+            "import \"common.mek\";\nusing Right = Shared[4];\n",
+        );
+        let root = write_file(
+            directory.path(),
+            "root.mek",
+            "import \"left.mek\";\nimport \"right.mek\";\nusing Root = uint16;\n",
+        );
+
+        let protocol = parse_protocol_with_imports(&root).expect("Parsing failed");
+        let names: Vec<String> = protocol
+            .definitions
+            .iter()
+            .map(|definition| match definition {
+                Definition::Type(type_def) => type_def.new_type.name.to_string(),
+                _ => panic!("Expected a TypeDefinition"),
+            })
+            .collect();
+        assert_eq!(names, vec!["Shared", "Left", "Right", "Root"]);
+        assert!(protocol.imports.is_empty());
+    }
+
+    #[test]
+    fn test_missing_import_is_reported() {
+        let directory = tempfile::tempdir().expect("Failed to create temp dir");
+        let root = write_file(directory.path(), "root.mek", "import \"missing.mek\";\n");
+
+        let error = parse_protocol_with_imports(&root).expect_err("Parsing should fail");
+        assert!(error.contains("Failed to resolve import missing.mek"));
+    }
+
+    #[test]
+    fn test_parse_error_in_import_is_reported_with_its_path() {
+        let directory = tempfile::tempdir().expect("Failed to create temp dir");
+        write_file(directory.path(), "broken.mek", "using Broken = int32[10;\n");
+        let root = write_file(directory.path(), "root.mek", "import \"broken.mek\";\n");
+
+        let error = parse_protocol_with_imports(&root).expect_err("Parsing should fail");
+        assert!(error.contains("broken.mek"));
+        assert!(error.contains("Parsing failed. Errors:"));
+    }
+
+    #[test]
+    fn test_import_cycle_parses_each_file_once() {
+        let directory = tempfile::tempdir().expect("Failed to create temp dir");
+        write_file(
+            directory.path(),
+            "first.mek",
+            "import \"second.mek\";\nusing First = uint8;\n",
+        );
+        write_file(
+            directory.path(),
+            "second.mek",
+            "import \"first.mek\";\nusing Second = uint16;\n",
+        );
+        let root = write_file(directory.path(), "root.mek", "import \"first.mek\";\n");
+
+        let protocol = parse_protocol_with_imports(&root).expect("Parsing failed");
+        assert_eq!(protocol.definitions.len(), 2);
+    }
+}
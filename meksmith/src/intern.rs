@@ -0,0 +1,157 @@
+//! String interner backing [`Identifier`] names.
+//!
+//! Protocol files repeat the same type and field names many times, and before
+//! interning every occurrence allocated its own `String`. [`InternedString`]
+//! deduplicates them: all instances holding the same text share a single
+//! allocation, which makes cloning a reference-count bump and equality a
+//! pointer comparison.
+//!
+//! [`Identifier`]: crate::ast::Identifier
+
+use std::collections::HashSet;
+use std::sync::{Arc, Mutex, OnceLock};
+
+/// Returns the process-wide intern table. Entries live for the lifetime of the
+/// process, which is acceptable because the set of distinct identifiers in
+/// protocol files is small and stable across parses.
+fn interner() -> &'static Mutex<HashSet<Arc<str>>> {
+    static INTERNER: OnceLock<Mutex<HashSet<Arc<str>>>> = OnceLock::new();
+    INTERNER.get_or_init(|| Mutex::new(HashSet::new()))
+}
+
+/// An immutable string with one shared allocation per distinct value.
+/// Two `InternedString`s holding the same text always point at the same
+/// allocation, so equality is a pointer comparison instead of a byte-wise one.
+#[derive(Clone, Eq)]
+pub struct InternedString(Arc<str>);
+
+impl InternedString {
+    /// Interns `value` and returns a handle to the shared allocation,
+    /// allocating only the first time a given value is seen.
+    pub fn new(value: &str) -> Self {
+        let mut table = interner().lock().expect("interner lock poisoned");
+        if let Some(existing) = table.get(value) {
+            return InternedString(existing.clone());
+        }
+        let shared: Arc<str> = Arc::from(value);
+        table.insert(shared.clone());
+        InternedString(shared)
+    }
+
+    /// Returns the interned text as a string slice.
+    pub fn as_str(&self) -> &str {
+        &self.0
+    }
+}
+
+impl PartialEq for InternedString {
+    fn eq(&self, other: &Self) -> bool {
+        // Interning guarantees one allocation per distinct value, so pointer
+        // equality is equivalent to (and much cheaper than) content equality.
+        Arc::ptr_eq(&self.0, &other.0)
+    }
+}
+
+impl PartialEq<str> for InternedString {
+    fn eq(&self, other: &str) -> bool {
+        self.as_str() == other
+    }
+}
+
+impl PartialEq<&str> for InternedString {
+    fn eq(&self, other: &&str) -> bool {
+        self.as_str() == *other
+    }
+}
+
+impl PartialEq<String> for InternedString {
+    fn eq(&self, other: &String) -> bool {
+        self.as_str() == other.as_str()
+    }
+}
+
+impl std::hash::Hash for InternedString {
+    fn hash<H: std::hash::Hasher>(&self, state: &mut H) {
+        // Hash the content (not the pointer) so lookups keyed by equal text
+        // land in the same bucket as lookups keyed by the interned handle.
+        self.as_str().hash(state);
+    }
+}
+
+impl std::borrow::Borrow<str> for InternedString {
+    // Sound because interning dedupes values: pointer equality (used by
+    // `PartialEq`) matches content equality, and `Hash` hashes the content.
+    fn borrow(&self) -> &str {
+        self.as_str()
+    }
+}
+
+impl std::ops::Deref for InternedString {
+    type Target = str;
+
+    fn deref(&self) -> &str {
+        self.as_str()
+    }
+}
+
+impl std::fmt::Display for InternedString {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        std::fmt::Display::fmt(self.as_str(), f)
+    }
+}
+
+impl std::fmt::Debug for InternedString {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        std::fmt::Debug::fmt(self.as_str(), f)
+    }
+}
+
+impl From<&str> for InternedString {
+    fn from(value: &str) -> Self {
+        InternedString::new(value)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_interned_string_shares_allocation() {
+        let first = InternedString::new("SharedName");
+        let second = InternedString::new("SharedName");
+        assert!(Arc::ptr_eq(&first.0, &second.0));
+    }
+
+    #[test]
+    fn test_interned_string_equality() {
+        let first = InternedString::new("EqualityName");
+        let second = InternedString::new("EqualityName");
+        let other = InternedString::new("OtherName");
+
+        assert_eq!(first, second);
+        assert_ne!(first, other);
+    }
+
+    #[test]
+    fn test_interned_string_compares_with_str_and_string() {
+        let interned = InternedString::new("MixedComparison");
+        assert_eq!(interned, "MixedComparison");
+        assert_eq!(interned, "MixedComparison".to_string());
+    }
+
+    #[test]
+    fn test_interned_string_as_str() {
+        let interned = InternedString::new("AsStrName");
+        assert_eq!(interned.as_str(), "AsStrName");
+    }
+
+    #[test]
+    fn test_interned_string_usable_as_hash_map_key() {
+        use std::collections::HashMap;
+
+        let mut map = HashMap::new();
+        map.insert(InternedString::new("Key"), 1);
+        assert_eq!(map.get(&InternedString::new("Key")), Some(&1));
+    }
+}
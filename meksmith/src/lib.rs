@@ -1,64 +1,72 @@
+pub mod arena;
 mod ast;
+mod ast_cache;
+pub mod diagnostics;
+pub mod graph;
+mod imports;
+mod intern;
+pub mod memo;
 mod parser;
+#[cfg(feature = "profiling")]
+pub mod profiling;
+pub mod session;
 pub mod smith_c;
+pub mod smith_rust;
+pub mod symbols;
 
-use crate::ast::*;
-use crate::parser::protocol;
-
-use chumsky::Parser;
-
-/// Based on the provided input, returns the line and column number of the error encountered during parsing.
-fn get_error_location(input: &str, error: crate::parser::RichError) -> (usize, usize) {
-    let mut line = 1;
-    let mut column = 1;
-
-    for (i, c) in input.char_indices() {
-        if i >= error.span().start && i < error.span().end {
-            return (line, column);
-        }
-        if c == '\n' {
-            line += 1;
-            column = 1;
-        } else {
-            column += 1;
-        }
-    }
+pub use crate::imports::parse_protocol_with_imports;
 
-    (line, column)
-}
+use crate::ast::*;
+use crate::diagnostics::{Diagnostic, LineIndex};
+use crate::parser::parse_protocol_cached;
 
 /// Parses a protocol from a string input and returns the resulting AST.
-pub fn parse_protocol_to_ast(input: &str) -> Result<Protocol, String> {
-    let result = protocol().parse(input);
+/// On failure it returns one [`Diagnostic`] per parse error, with positions
+/// resolved through a [`LineIndex`] built once for the whole input.
+/// The parser itself is built once per thread and reused across calls.
+pub fn parse_protocol_to_ast(input: &str) -> Result<Protocol, Vec<Diagnostic>> {
+    let result = parse_protocol_cached(input);
 
     match result.into_result() {
         Ok(ast) => Ok(ast),
         Err(errors) => {
-            let error_messages: Vec<String> = errors
+            let line_index = LineIndex::new(input);
+            Err(errors
                 .into_iter()
-                .map(|e| {
-                    let (line, column) = get_error_location(input, e.clone());
-                    e.to_string()
-                        + " in "
-                        + line.to_string().as_str()
-                        + ":"
-                        + column.to_string().as_str()
+                .map(|error| {
+                    let span = error.span().start..error.span().end;
+                    let (line, column) = line_index.location(span.start);
+                    Diagnostic {
+                        span,
+                        line,
+                        column,
+                        message: error.to_string(),
+                    }
                 })
-                .collect();
-            Err(format!(
-                "Parsing failed. Errors: {}",
-                error_messages.join(", ")
-            ))
+                .collect())
         }
     }
 }
 
 /// Parses a protocol from a file and returns the resulting AST. Similar to `parse_protocol_to_ast`,
-/// but reads the input from a file instead of a string.
+/// but reads the input from a file instead of a string, and joins all diagnostics
+/// into a single error message.
+///
+/// The AST is cached next to the file as `<file>.mekast`, keyed by a hash of
+/// the source text; while the file is unchanged, later calls decode the cached
+/// AST instead of parsing (see the `ast_cache` module).
 pub fn parse_protocol_from_file_to_ast(file_path: &str) -> Result<Protocol, String> {
     let input =
         std::fs::read_to_string(file_path).map_err(|e| format!("Failed to read file: {e}"))?;
-    parse_protocol_to_ast(&input)
+
+    if let Some(protocol) = ast_cache::load(file_path, &input) {
+        return Ok(protocol);
+    }
+
+    let protocol = parse_protocol_to_ast(&input)
+        .map_err(|diagnostics| diagnostics::join_diagnostics(&diagnostics))?;
+    ast_cache::store(file_path, &input, &protocol);
+    Ok(protocol)
 }
 
 #[cfg(test)]
@@ -89,6 +97,9 @@ using MyType = int32[10];
         }
     }
 
+    // The profiling wrappers re-anchor parse errors at rule entry, so the
+    // exact message differs in a profiling build; see the profiling module.
+    #[cfg(not(feature = "profiling"))]
     #[test]
     fn test_parse_protocol_to_ast_with_errors() {
         let input = r#"
@@ -97,11 +108,14 @@ using MyType = int32[10;
 
         let result = parse_protocol_to_ast(input);
         assert!(result.is_err());
-        assert!(
-            result
-                .unwrap_err()
-                .contains("Parsing failed. Errors: found ';' expected digit, or right bracket")
+        let diagnostics = result.unwrap_err();
+        assert_eq!(diagnostics.len(), 1);
+        assert_eq!(
+            diagnostics[0].message,
+            "found ';' expected digit, or right bracket (])"
         );
+        assert_eq!(diagnostics[0].line, 2);
+        assert_eq!(diagnostics[0].column, 24);
     }
 
     #[test]
@@ -137,5 +151,7 @@ using MyType = int32[10];
             panic!("Expected a TypeDefinition");
         }
         std::fs::remove_file(file_path).expect("Failure in removing test file");
+        std::fs::remove_file(ast_cache::cache_path(file_path))
+            .expect("Failure in removing cache file");
     }
 }
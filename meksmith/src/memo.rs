@@ -0,0 +1,203 @@
+//! Content-hash memoization for repeated whole-source generation.
+//!
+//! [`MemoizedSmith`] serves callers that repeatedly receive the complete
+//! source text instead of edit ranges — the website worker gets the whole
+//! editor buffer with every message. The source is split into the same
+//! top-level chunks as [`ParseSession`](crate::session::ParseSession), and
+//! both the parsed definitions of each chunk and the generated C fragment of
+//! each definition are cached by a content hash. An edit to one definition
+//! therefore only re-parses and re-generates that definition; every other
+//! fragment is pasted from the cache, so the per-edit cost is proportional to
+//! the edited definition rather than the whole protocol.
+//!
+//! The caches are pruned to the entries the latest input used, so their size
+//! stays bounded by the current source.
+
+use crate::ast::{Definition, Protocol, sort_protocol_by_dependencies};
+use crate::ast_cache::{content_hash, write_definition};
+use crate::diagnostics::{Diagnostic, LineIndex, join_diagnostics};
+use crate::parser::parse_protocol_cached;
+use crate::session::scan_chunk_ranges;
+use crate::smith_c::{code_header, emit_definition_code, estimate_definition_size};
+
+use std::collections::HashMap;
+
+/// The parsed contents of one source chunk, keyed by the chunk's text hash.
+#[derive(Debug, Clone)]
+struct ChunkEntry {
+    imports: Vec<String>,
+    definitions: Vec<Definition>,
+}
+
+/// A C code generator that memoizes per-definition work across calls.
+///
+/// Feed it the full source after every edit with
+/// [`generate_c_code`](MemoizedSmith::generate_c_code); the output is
+/// byte-for-byte identical to
+/// [`generate_c_code_from_string`](crate::smith_c::generate_c_code_from_string).
+#[derive(Debug, Default)]
+pub struct MemoizedSmith {
+    /// Parsed chunks, keyed by a hash of the chunk's source text.
+    chunks: HashMap<u64, ChunkEntry>,
+    /// Generated C fragments, keyed by a hash of the serialized definition.
+    /// Keying by the definition instead of the chunk keeps a fragment valid
+    /// when its definition merely moves within the source.
+    fragments: HashMap<u64, String>,
+}
+
+impl MemoizedSmith {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Generates the C code for `input`, reusing the cached parse of every
+    /// unchanged chunk and the cached fragment of every unchanged definition.
+    ///
+    /// Erroring chunks are never cached: their diagnostics carry line numbers
+    /// of the current input, so they are re-derived on every call.
+    pub fn generate_c_code(&mut self, input: &str) -> Result<String, String> {
+        let line_index = LineIndex::new(input);
+        let mut diagnostics = Vec::new();
+        let mut chunks = HashMap::new();
+        let mut protocol = Protocol {
+            imports: Vec::new(),
+            definitions: Vec::new(),
+        };
+
+        for range in scan_chunk_ranges(input, 0) {
+            let text = &input[range.clone()];
+            let key = content_hash(text.as_bytes());
+            let entry = match self
+                .chunks
+                .remove(&key)
+                .or_else(|| chunks.get(&key).cloned())
+            {
+                Some(entry) => entry,
+                None => match parse_protocol_cached(text).into_result() {
+                    Ok(parsed) => ChunkEntry {
+                        imports: parsed.imports,
+                        definitions: parsed.definitions,
+                    },
+                    Err(errors) => {
+                        for error in errors {
+                            let span =
+                                range.start + error.span().start..range.start + error.span().end;
+                            let (line, column) = line_index.location(span.start);
+                            diagnostics.push(Diagnostic {
+                                span,
+                                line,
+                                column,
+                                message: error.to_string(),
+                            });
+                        }
+                        continue;
+                    }
+                },
+            };
+            protocol.imports.extend(entry.imports.iter().cloned());
+            protocol
+                .definitions
+                .extend(entry.definitions.iter().cloned());
+            chunks.insert(key, entry);
+        }
+        self.chunks = chunks;
+
+        if !diagnostics.is_empty() {
+            return Err(join_diagnostics(&diagnostics));
+        }
+        let sorted = sort_protocol_by_dependencies(&protocol)?;
+
+        let mut fragments = HashMap::new();
+        let mut code = String::new();
+        code.push_str(code_header(&sorted));
+        for definition in &sorted.definitions {
+            let mut bytes = Vec::new();
+            write_definition(&mut bytes, definition);
+            let key = content_hash(&bytes);
+            let fragment = self
+                .fragments
+                .remove(&key)
+                .or_else(|| fragments.get(&key).cloned())
+                .unwrap_or_else(|| {
+                    let mut piece = String::with_capacity(estimate_definition_size(definition));
+                    emit_definition_code(&mut piece, definition)
+                        .expect("writing to a String cannot fail");
+                    piece
+                });
+            code.push_str(&fragment);
+            fragments.insert(key, fragment);
+        }
+        self.fragments = fragments;
+        Ok(code)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::smith_c::generate_c_code_from_string;
+
+    static SOURCE: &str = "using MyType = int32[10];\n# comment\nenum MyEnum {\n    first = 1;\n    second = 2;\n};\nstruct MyStruct {\n    field: uint8;\n    mac: byte[6];\n};\n";
+
+    #[test]
+    fn test_memoized_output_matches_direct_generation() {
+        let mut smith = MemoizedSmith::new();
+        let expected = generate_c_code_from_string(SOURCE).expect("Generation failed");
+        assert_eq!(smith.generate_c_code(SOURCE).as_deref(), Ok(&*expected));
+        // The second call is served from the caches and must be identical.
+        assert_eq!(smith.generate_c_code(SOURCE).as_deref(), Ok(&*expected));
+    }
+
+    #[test]
+    fn test_unchanged_definitions_reuse_cached_fragments() {
+        let mut smith = MemoizedSmith::new();
+        smith.generate_c_code(SOURCE).expect("Generation failed");
+
+        // Poison the cached enum fragment: if the second call re-generates it
+        // instead of reusing the cache, the marker disappears.
+        let marker = "/* cached fragment reused */\n";
+        let (&key, _) = smith
+            .fragments
+            .iter()
+            .find(|(_, fragment)| fragment.contains("MyEnum"))
+            .expect("The enum fragment should be cached");
+        smith.fragments.insert(key, marker.to_string());
+
+        let edited = SOURCE.replace("field: uint8;", "field: uint16;");
+        let output = smith.generate_c_code(&edited).expect("Generation failed");
+        assert!(output.contains(marker));
+        assert!(output.contains("uint16_t field"));
+    }
+
+    #[test]
+    fn test_caches_are_pruned_to_the_current_source() {
+        let mut smith = MemoizedSmith::new();
+        smith.generate_c_code(SOURCE).expect("Generation failed");
+
+        // No trailing newline: trailing text would form a chunk of its own.
+        smith
+            .generate_c_code("using MyType = int32[10];")
+            .expect("Generation failed");
+        assert_eq!(smith.chunks.len(), 1);
+        assert_eq!(smith.fragments.len(), 1);
+    }
+
+    #[test]
+    fn test_parse_errors_are_reported_on_every_call() {
+        let mut smith = MemoizedSmith::new();
+        let broken = SOURCE.replace("field:", "field");
+
+        let first = smith.generate_c_code(&broken);
+        let second = smith.generate_c_code(&broken);
+        assert!(first.is_err());
+        assert_eq!(first, second);
+        // The profiling wrappers re-anchor parse errors, so exact messages
+        // only line up in a default build.
+        #[cfg(not(feature = "profiling"))]
+        assert_eq!(
+            first,
+            generate_c_code_from_string(&broken),
+            "Errors must match the unmemoized pipeline"
+        );
+    }
+}
@@ -1,6 +1,7 @@
 //! Grammar for the meklang is defined as follows:
 //! ```text
-//! <protocol> ::= (<definition> | <comment>)+
+//! <protocol> ::= (<import> | <definition> | <comment>)+
+//! <import> ::= 'import' '"' <path> '"' <semicolon>
 //! <comment> ::= '#' <text> '\n'
 //! <definition> ::=
 //!       <enumeration_definition>
@@ -54,6 +55,7 @@
 //! <decimal> ::= [0-9]+
 //!
 //! <text> ::= [^\n]*
+//! <path> ::= [^"]*
 //!
 //! <left_brace> ::= '{'
 //! <right_brace> ::= '}'
@@ -74,159 +76,238 @@
 
 use crate::ast::*;
 
+use chumsky::cache::{Cache, Cached};
 use chumsky::prelude::*;
 
 pub(crate) type RichError<'src> = chumsky::error::Rich<'src, char>;
 pub(crate) type ErrorType<'src> = extra::Err<RichError<'src>>;
 
+/// Wraps a named grammar rule with the per-rule instrumentation of the
+/// `profiling` feature: every run of the rule is counted and timed, and runs
+/// that fail (i.e. backtrack into an alternative) are counted separately.
+/// See [`profiling`](crate::profiling) for reading the collected report.
+#[cfg(feature = "profiling")]
+fn rule<'src, O>(
+    name: &'static str,
+    parser: impl Parser<'src, &'src str, O, ErrorType<'src>>,
+) -> impl Parser<'src, &'src str, O, ErrorType<'src>> {
+    custom(move |input| {
+        let start = std::time::Instant::now();
+        let result = input.parse(&parser);
+        crate::profiling::record(name, start.elapsed(), result.is_err());
+        result
+    })
+}
+
+/// Without the `profiling` feature a rule wrapper is the rule itself.
+#[cfg(not(feature = "profiling"))]
+#[inline(always)]
+fn rule<'src, O>(
+    _name: &'static str,
+    parser: impl Parser<'src, &'src str, O, ErrorType<'src>>,
+) -> impl Parser<'src, &'src str, O, ErrorType<'src>> {
+    parser
+}
+
 /// Parses a left brace `{` followed by optional whitespace.
 pub(crate) fn left_brace<'src>() -> impl Parser<'src, &'src str, (), ErrorType<'src>> {
-    just('{').padded().to(()).labelled("left brace ({)")
+    rule(
+        "left_brace",
+        just('{').padded().to(()).labelled("left brace ({)"),
+    )
 }
 
 /// Parses a left brace `}` followed by optional whitespace.
 pub(crate) fn right_brace<'src>() -> impl Parser<'src, &'src str, (), ErrorType<'src>> {
-    just('}').padded().to(()).labelled("right brace (})")
+    rule(
+        "right_brace",
+        just('}').padded().to(()).labelled("right brace (})"),
+    )
 }
 
 /// Parses a left bracket `[` followed by optional whitespace.
 pub(crate) fn left_bracket<'src>() -> impl Parser<'src, &'src str, (), ErrorType<'src>> {
-    just('[').padded().to(()).labelled("left bracket ([)")
+    rule(
+        "left_bracket",
+        just('[').padded().to(()).labelled("left bracket ([)"),
+    )
 }
 
 /// Parses a right bracket `]` followed by optional whitespace.
 pub(crate) fn right_bracket<'src>() -> impl Parser<'src, &'src str, (), ErrorType<'src>> {
-    just(']').padded().to(()).labelled("right bracket (])")
+    rule(
+        "right_bracket",
+        just(']').padded().to(()).labelled("right bracket (])"),
+    )
 }
 
 /// Parses a semicolon `;` followed by optional whitespace.
 pub(crate) fn semicolon<'src>() -> impl Parser<'src, &'src str, (), ErrorType<'src>> {
-    just(';').padded().to(()).labelled("semicolon (;)")
+    rule(
+        "semicolon",
+        just(';').padded().to(()).labelled("semicolon (;)"),
+    )
 }
 
 /// Parses a colon `:` followed by optional whitespace.
 pub(crate) fn colon<'src>() -> impl Parser<'src, &'src str, (), ErrorType<'src>> {
-    just(':').padded().to(()).labelled("colon (:)")
+    rule("colon", just(':').padded().to(()).labelled("colon (:)"))
 }
 
 /// Parses a maps to operator `=>` followed by optional whitespace.
 pub(crate) fn maps_to<'src>() -> impl Parser<'src, &'src str, (), ErrorType<'src>> {
-    just("=>").padded().to(()).labelled("maps to (=>)")
+    rule(
+        "maps_to",
+        just("=>").padded().to(()).labelled("maps to (=>)"),
+    )
 }
 
 /// Parses an equal sign `=` followed by optional whitespace.
 pub(crate) fn equal<'src>() -> impl Parser<'src, &'src str, (), ErrorType<'src>> {
-    just('=').padded().to(()).labelled("equal (=)")
+    rule("equal", just('=').padded().to(()).labelled("equal (=)"))
 }
 
 /// Parses a comma `,` followed by optional whitespace.
 pub(crate) fn comma<'src>() -> impl Parser<'src, &'src str, (), ErrorType<'src>> {
-    just(',').padded().to(()).labelled("comma (,)")
+    rule("comma", just(',').padded().to(()).labelled("comma (,)"))
 }
 
 /// Parses a double dot `..` followed by optional whitespace.
 pub(crate) fn double_dot<'src>() -> impl Parser<'src, &'src str, (), ErrorType<'src>> {
-    just("..").padded().to(()).labelled("double dot (..)")
+    rule(
+        "double_dot",
+        just("..").padded().to(()).labelled("double dot (..)"),
+    )
 }
 
-/// Parses an unsigned integer in hexadecimal format.
+/// Parses an unsigned integer in hexadecimal format. The digits are sliced
+/// straight from the input, so the token allocates nothing.
 pub(crate) fn hexadecimal<'src>() -> impl Parser<'src, &'src str, u64, ErrorType<'src>> {
-    just("0x")
-        .ignore_then(text::digits(16).at_least(1).collect::<String>())
-        .map(|s: String| u64::from_str_radix(&s, 16).unwrap())
-        .labelled("hexadecimal")
-        .padded()
+    rule(
+        "hexadecimal",
+        just("0x")
+            .ignore_then(text::digits(16).at_least(1).to_slice())
+            .map(|digits: &str| u64::from_str_radix(digits, 16).unwrap())
+            .labelled("hexadecimal")
+            .padded(),
+    )
 }
 
 /// Parses an unsigned integer in binary format. It supports leading zeros and
-/// only allows `0` and `1` digits.
+/// only allows `0` and `1` digits. The digits are sliced straight from the
+/// input, so the token allocates nothing.
 pub(crate) fn binary<'src>() -> impl Parser<'src, &'src str, u64, ErrorType<'src>> {
-    just("0b")
-        .ignore_then(text::digits(2).at_least(1).collect::<String>())
-        .map(|s: String| u64::from_str_radix(&s, 2).unwrap())
-        .labelled("binary")
-        .padded()
+    rule(
+        "binary",
+        just("0b")
+            .ignore_then(text::digits(2).at_least(1).to_slice())
+            .map(|digits: &str| u64::from_str_radix(digits, 2).unwrap())
+            .labelled("binary")
+            .padded(),
+    )
 }
 
-/// Parses an unsigned integer in decimal format.
+/// Parses an unsigned integer in decimal format. The digits are sliced
+/// straight from the input, so the token allocates nothing.
 pub(crate) fn decimal<'src>() -> impl Parser<'src, &'src str, u64, ErrorType<'src>> {
-    text::digits(10)
-        .at_least(1)
-        .collect::<String>()
-        .map(|s: String| s.parse::<u64>().unwrap())
-        .labelled("decimal")
-        .padded()
+    rule(
+        "decimal",
+        text::digits(10)
+            .at_least(1)
+            .to_slice()
+            .map(|digits: &str| digits.parse::<u64>().unwrap())
+            .labelled("decimal")
+            .padded(),
+    )
 }
 
 /// Parses an unsigned integer in decimal, hexadecimal, or binary format.
 pub(crate) fn unsigned_integer<'src>() -> impl Parser<'src, &'src str, u64, ErrorType<'src>> {
-    choice((hexadecimal(), binary(), decimal())).labelled("unsigned_integer")
+    rule(
+        "unsigned_integer",
+        choice((hexadecimal(), binary(), decimal())).labelled("unsigned_integer"),
+    )
 }
 
 /// Parses an identifier from the input string. Identifier has to start with
 /// either alphabetic characters or an underscore, followed by alphanumeric
 /// characters or underscores.
 pub(crate) fn identifier<'src>() -> impl Parser<'src, &'src str, Identifier, ErrorType<'src>> {
-    text::ident()
-        .map(|s: &str| Identifier::new(s))
-        .labelled("identifier")
-        .padded()
+    rule(
+        "identifier",
+        text::ident()
+            .map(|s: &str| Identifier::new(s))
+            .labelled("identifier")
+            .padded(),
+    )
 }
 
 /// Parses a built-in type identifier from the input string.
 pub(crate) fn builtin_type<'src>() -> impl Parser<'src, &'src str, TypeIdentifier, ErrorType<'src>>
 {
-    choice((
-        just("int8").to(TypeIdentifier::Integer8),
-        just("int16").to(TypeIdentifier::Integer16),
-        just("int32").to(TypeIdentifier::Integer32),
-        just("int64").to(TypeIdentifier::Integer64),
-        just("uint8").to(TypeIdentifier::UnsignedInteger8),
-        just("uint16").to(TypeIdentifier::UnsignedInteger16),
-        just("uint32").to(TypeIdentifier::UnsignedInteger32),
-        just("uint64").to(TypeIdentifier::UnsignedInteger64),
-        just("float32").to(TypeIdentifier::Float32),
-        just("float64").to(TypeIdentifier::Float64),
-        just("bit").to(TypeIdentifier::Bit),
-        just("byte").to(TypeIdentifier::Byte),
-    ))
-    .labelled("builtin type")
+    rule(
+        "builtin_type",
+        choice((
+            just("int8").to(TypeIdentifier::Integer8),
+            just("int16").to(TypeIdentifier::Integer16),
+            just("int32").to(TypeIdentifier::Integer32),
+            just("int64").to(TypeIdentifier::Integer64),
+            just("uint8").to(TypeIdentifier::UnsignedInteger8),
+            just("uint16").to(TypeIdentifier::UnsignedInteger16),
+            just("uint32").to(TypeIdentifier::UnsignedInteger32),
+            just("uint64").to(TypeIdentifier::UnsignedInteger64),
+            just("float32").to(TypeIdentifier::Float32),
+            just("float64").to(TypeIdentifier::Float64),
+            just("bit").to(TypeIdentifier::Bit),
+            just("byte").to(TypeIdentifier::Byte),
+        ))
+        .labelled("builtin type"),
+    )
 }
 
 /// Parses a user-defined type identifier from the input string.
 pub(crate) fn user_defined_type<'src>()
 -> impl Parser<'src, &'src str, TypeIdentifier, ErrorType<'src>> {
-    identifier()
-        .map(TypeIdentifier::UserDefined)
-        .labelled("user defined type")
-        .padded()
+    rule(
+        "user_defined_type",
+        identifier()
+            .map(TypeIdentifier::UserDefined)
+            .labelled("user defined type")
+            .padded(),
+    )
 }
 
 /// Parses a static array type identifier from the input string.
 pub(crate) fn static_array_type<'src>()
 -> impl Parser<'src, &'src str, TypeIdentifier, ErrorType<'src>> {
-    choice((builtin_type(), user_defined_type()))
-        .then_ignore(left_bracket())
-        .then(unsigned_integer())
-        .then_ignore(right_bracket())
-        .map(|(r#type, size)| TypeIdentifier::StaticArray {
-            r#type: Box::new(r#type),
-            size,
-        })
-        .labelled("static array type")
-        .padded()
+    rule(
+        "static_array_type",
+        choice((builtin_type(), user_defined_type()))
+            .then_ignore(left_bracket())
+            .then(unsigned_integer())
+            .then_ignore(right_bracket())
+            .map(|(r#type, size)| TypeIdentifier::StaticArray {
+                r#type: Box::new(r#type),
+                size,
+            })
+            .labelled("static array type")
+            .padded(),
+    )
 }
 
 pub(crate) fn dynamic_array_type<'src>()
 -> impl Parser<'src, &'src str, TypeIdentifier, ErrorType<'src>> {
-    choice((builtin_type(), user_defined_type()))
-        .then_ignore(left_bracket())
-        .then_ignore(right_bracket())
-        .map(|r#type| TypeIdentifier::DynamicArray {
-            r#type: Box::new(r#type),
-        })
-        .labelled("dynamic array type")
-        .padded()
+    rule(
+        "dynamic_array_type",
+        choice((builtin_type(), user_defined_type()))
+            .then_ignore(left_bracket())
+            .then_ignore(right_bracket())
+            .map(|r#type| TypeIdentifier::DynamicArray {
+                r#type: Box::new(r#type),
+            })
+            .labelled("dynamic array type")
+            .padded(),
+    )
 }
 
 /// Parses a type identifier from the input string. It can be a predefined type
@@ -235,289 +316,419 @@ pub(crate) fn dynamic_array_type<'src>()
 /// The static array is defined as `type[size]`, and the dynamic array is defined as `type[]`.
 pub(crate) fn type_identifier<'src>()
 -> impl Parser<'src, &'src str, TypeIdentifier, ErrorType<'src>> {
-    recursive(|_| {
-        choice((
-            static_array_type().boxed(),
-            dynamic_array_type().boxed(),
-            builtin_type().boxed(),
-            user_defined_type().boxed(),
-        ))
-    })
+    rule(
+        "type_identifier",
+        recursive(|_| {
+            choice((
+                static_array_type().boxed(),
+                dynamic_array_type().boxed(),
+                builtin_type().boxed(),
+                user_defined_type().boxed(),
+            ))
+        }),
+    )
 }
 
 /// Parses a single value enumeration field in the format `name = value;`
 pub(crate) fn enumeration_field_single_value<'src>()
 -> impl Parser<'src, &'src str, EnumerationField, ErrorType<'src>> {
-    identifier()
-        .then_ignore(equal())
-        .then(unsigned_integer())
-        .then_ignore(semicolon())
-        .map(|(name, value)| EnumerationField::SingleValue { name, value })
-        .labelled("enumeration field single value")
-        .padded()
+    rule(
+        "enumeration_field_single_value",
+        identifier()
+            .then_ignore(equal())
+            .then(unsigned_integer())
+            .then_ignore(semicolon())
+            .map(|(name, value)| EnumerationField::SingleValue { name, value })
+            .labelled("enumeration field single value")
+            .padded(),
+    )
 }
 
 /// Parses a range of values defined by `start..end`.
 pub(crate) fn range<'src>() -> impl Parser<'src, &'src str, (u64, u64), ErrorType<'src>> {
-    unsigned_integer()
-        .then_ignore(double_dot())
-        .then(unsigned_integer())
-        .map(|(start, end)| (start, end))
-        .labelled("range")
-        .padded()
+    rule(
+        "range",
+        unsigned_integer()
+            .then_ignore(double_dot())
+            .then(unsigned_integer())
+            .map(|(start, end)| (start, end))
+            .labelled("range")
+            .padded(),
+    )
 }
 
 /// Parses a range of values enumeration field in the format `name = start..end;`
 pub(crate) fn enumeration_field_range_of_values<'src>()
 -> impl Parser<'src, &'src str, EnumerationField, ErrorType<'src>> {
-    identifier()
-        .then_ignore(equal())
-        .then(range())
-        .then_ignore(semicolon())
-        .map(|(name, (start, end))| EnumerationField::RangeOfValues { name, start, end })
-        .labelled("enumeration field range of values")
-        .padded()
+    rule(
+        "enumeration_field_range_of_values",
+        identifier()
+            .then_ignore(equal())
+            .then(range())
+            .then_ignore(semicolon())
+            .map(|(name, (start, end))| EnumerationField::RangeOfValues { name, start, end })
+            .labelled("enumeration field range of values")
+            .padded(),
+    )
 }
 
 /// Parses an enumeration field from the input string.
 pub(crate) fn enumeration_field<'src>()
 -> impl Parser<'src, &'src str, EnumerationField, ErrorType<'src>> {
-    choice((
-        enumeration_field_single_value(),
-        enumeration_field_range_of_values(),
-    ))
-    .labelled("enumeration field")
-    .padded()
+    rule(
+        "enumeration_field",
+        choice((
+            enumeration_field_single_value(),
+            enumeration_field_range_of_values(),
+        ))
+        .labelled("enumeration field")
+        .padded(),
+    )
 }
 
 /// Parses an enumeration with fields.
 pub(crate) fn enumeration_definition<'src>()
 -> impl Parser<'src, &'src str, EnumerationDefinition, ErrorType<'src>> {
-    just("enum")
-        .padded()
-        .ignore_then(identifier())
-        .then_ignore(left_brace())
-        .then(
-            enumeration_field()
-                .repeated()
-                .at_least(1)
-                .collect::<Vec<EnumerationField>>(),
-        )
-        .then_ignore(right_brace())
-        .then_ignore(semicolon())
-        .map(|(name, fields)| EnumerationDefinition { name, fields })
-        .labelled("enumeration")
-        .padded()
+    rule(
+        "enumeration_definition",
+        just("enum")
+            .padded()
+            .ignore_then(identifier())
+            .then_ignore(left_brace())
+            .then(
+                enumeration_field()
+                    .repeated()
+                    .at_least(1)
+                    .collect::<Vec<EnumerationField>>(),
+            )
+            .then_ignore(right_brace())
+            .then_ignore(semicolon())
+            .map(|(name, fields)| EnumerationDefinition { name, fields })
+            .labelled("enumeration")
+            .padded(),
+    )
 }
 
 /// Parses a single structure field attribute, which consists of a name and a value.
 pub(crate) fn attribute<'src>() -> impl Parser<'src, &'src str, Attribute, ErrorType<'src>> {
-    choice((
-        just("discriminated_by")
-            .ignore_then(equal())
-            .ignore_then(identifier())
-            .map(|field| Attribute::DiscriminatedBy { field }),
-        just("bits")
-            .ignore_then(equal())
-            .ignore_then(unsigned_integer())
-            .map(|size| Attribute::BitsSize { size }),
-        just("bytes")
-            .ignore_then(equal())
-            .ignore_then(unsigned_integer())
-            .map(|size| Attribute::BytesSize { size }),
-    ))
-    .labelled("attribute")
-    .padded()
+    rule(
+        "attribute",
+        choice((
+            just("discriminated_by")
+                .ignore_then(equal())
+                .ignore_then(identifier())
+                .map(|field| Attribute::DiscriminatedBy { field }),
+            just("bits")
+                .ignore_then(equal())
+                .ignore_then(unsigned_integer())
+                .map(|size| Attribute::BitsSize { size }),
+            just("bytes")
+                .ignore_then(equal())
+                .ignore_then(unsigned_integer())
+                .map(|size| Attribute::BytesSize { size }),
+        ))
+        .labelled("attribute")
+        .padded(),
+    )
 }
 
 /// Parses a structure field attribute tail, which is a comma followed by another attribute.
 pub(crate) fn attribute_tail<'src>() -> impl Parser<'src, &'src str, Attribute, ErrorType<'src>> {
-    comma()
-        .padded()
-        .ignore_then(attribute())
-        .labelled("attribute tail")
-        .padded()
+    rule(
+        "attribute_tail",
+        comma()
+            .padded()
+            .ignore_then(attribute())
+            .labelled("attribute tail")
+            .padded(),
+    )
 }
 
 /// Parses a collection of structure field attributes, which are enclosed in square brackets
 /// and separated by commas.
 pub(crate) fn attributes<'src>() -> impl Parser<'src, &'src str, Vec<Attribute>, ErrorType<'src>> {
-    left_bracket()
-        .padded()
-        .ignore_then(
-            attribute()
-                .then(attribute_tail().repeated().collect::<Vec<_>>())
-                .map(|(first, rest)| {
-                    let mut attrs = vec![first];
-                    attrs.extend(rest);
-                    attrs
-                }),
-        )
-        .then_ignore(right_bracket())
-        .labelled("attributes")
-        .padded()
+    rule(
+        "attributes",
+        left_bracket()
+            .padded()
+            .ignore_then(
+                attribute()
+                    .then(attribute_tail().repeated().collect::<Vec<_>>())
+                    .map(|(first, rest)| {
+                        let mut attrs = vec![first];
+                        attrs.extend(rest);
+                        attrs
+                    }),
+            )
+            .then_ignore(right_bracket())
+            .labelled("attributes")
+            .padded(),
+    )
 }
 
 /// Parses a structure field, which consists of a name and a type identifier.
 pub(crate) fn structure_field<'src>()
 -> impl Parser<'src, &'src str, StructureField, ErrorType<'src>> {
-    attributes()
-        .or_not()
-        .map(|attrs| attrs.unwrap_or_default())
-        .then(identifier())
-        .then_ignore(colon())
-        .then(type_identifier())
-        .then_ignore(semicolon())
-        .map(|((attributes, name), r#type)| StructureField {
-            attributes,
-            name,
-            r#type,
-        })
-        .labelled("structure field")
-        .padded()
+    rule(
+        "structure_field",
+        attributes()
+            .or_not()
+            .map(|attrs| attrs.unwrap_or_default())
+            .then(identifier())
+            .then_ignore(colon())
+            .then(type_identifier())
+            .then_ignore(semicolon())
+            .map(|((attributes, name), r#type)| StructureField {
+                attributes,
+                name,
+                r#type,
+            })
+            .labelled("structure field")
+            .padded(),
+    )
 }
 
 /// Parses a structure definition, which consists of a name and a collection of fields.
 pub(crate) fn structure_definition<'src>()
 -> impl Parser<'src, &'src str, StructureDefinition, ErrorType<'src>> {
-    just("struct")
-        .padded()
-        .ignore_then(identifier())
-        .then_ignore(left_brace())
-        .then(
-            structure_field()
-                .repeated()
-                .at_least(1)
-                .collect::<Vec<StructureField>>(),
-        )
-        .then_ignore(right_brace())
-        .then_ignore(semicolon())
-        .map(|(name, fields)| StructureDefinition { name, fields })
-        .labelled("structure definition")
-        .padded()
+    rule(
+        "structure_definition",
+        just("struct")
+            .padded()
+            .ignore_then(identifier())
+            .then_ignore(left_brace())
+            .then(
+                structure_field()
+                    .repeated()
+                    .at_least(1)
+                    .collect::<Vec<StructureField>>(),
+            )
+            .then_ignore(right_brace())
+            .then_ignore(semicolon())
+            .map(|(name, fields)| StructureDefinition { name, fields })
+            .labelled("structure definition")
+            .padded(),
+    )
 }
 
 /// Parses a union field with a single discriminator, which consists of a discriminator, name, and type identifier.
 pub(crate) fn union_field_single_value<'src>()
 -> impl Parser<'src, &'src str, UnionField, ErrorType<'src>> {
-    unsigned_integer()
-        .then_ignore(maps_to())
-        .then(identifier())
-        .then_ignore(colon())
-        .then(type_identifier())
-        .then_ignore(semicolon())
-        .map(|((discriminator, name), r#type)| UnionField::SingleValue {
-            name,
-            r#type,
-            discriminator,
-        })
-        .labelled("union field")
-        .padded()
+    rule(
+        "union_field_single_value",
+        unsigned_integer()
+            .then_ignore(maps_to())
+            .then(identifier())
+            .then_ignore(colon())
+            .then(type_identifier())
+            .then_ignore(semicolon())
+            .map(|((discriminator, name), r#type)| UnionField::SingleValue {
+                name,
+                r#type,
+                discriminator,
+            })
+            .labelled("union field")
+            .padded(),
+    )
 }
 
 /// Parses a union field with a range of discriminators, which consists of a start and end discriminator, name, and type identifier.
 pub(crate) fn union_field_range_of_values<'src>()
 -> impl Parser<'src, &'src str, UnionField, ErrorType<'src>> {
-    range()
-        .then_ignore(maps_to())
-        .then(identifier())
-        .then_ignore(colon())
-        .then(type_identifier())
-        .then_ignore(semicolon())
-        .map(
-            |(((start_discriminator, end_discriminator), name), r#type)| {
-                UnionField::RangeOfValues {
-                    name,
-                    r#type,
-                    start_discriminator,
-                    end_discriminator,
-                }
-            },
-        )
-        .labelled("union field range of values")
-        .padded()
+    rule(
+        "union_field_range_of_values",
+        range()
+            .then_ignore(maps_to())
+            .then(identifier())
+            .then_ignore(colon())
+            .then(type_identifier())
+            .then_ignore(semicolon())
+            .map(
+                |(((start_discriminator, end_discriminator), name), r#type)| {
+                    UnionField::RangeOfValues {
+                        name,
+                        r#type,
+                        start_discriminator,
+                        end_discriminator,
+                    }
+                },
+            )
+            .labelled("union field range of values")
+            .padded(),
+    )
 }
 
 /// Parses a union field, which can either be a single value or a range of values.
 pub(crate) fn union_field<'src>() -> impl Parser<'src, &'src str, UnionField, ErrorType<'src>> {
-    choice((union_field_single_value(), union_field_range_of_values()))
-        .labelled("union field")
-        .padded()
+    rule(
+        "union_field",
+        choice((union_field_single_value(), union_field_range_of_values()))
+            .labelled("union field")
+            .padded(),
+    )
 }
 
 /// Parses a union definition, which consists of a name and a collection of union fields.
 pub(crate) fn union_definition<'src>()
 -> impl Parser<'src, &'src str, UnionDefinition, ErrorType<'src>> {
-    just("union")
-        .padded()
-        .ignore_then(identifier())
-        .then_ignore(left_brace())
-        .then(
-            union_field()
-                .repeated()
-                .at_least(1)
-                .collect::<Vec<UnionField>>(),
-        )
-        .then_ignore(right_brace())
-        .then_ignore(semicolon())
-        .map(|(name, fields)| UnionDefinition { name, fields })
-        .labelled("union")
-        .padded()
+    rule(
+        "union_definition",
+        just("union")
+            .padded()
+            .ignore_then(identifier())
+            .then_ignore(left_brace())
+            .then(
+                union_field()
+                    .repeated()
+                    .at_least(1)
+                    .collect::<Vec<UnionField>>(),
+            )
+            .then_ignore(right_brace())
+            .then_ignore(semicolon())
+            .map(|(name, fields)| UnionDefinition { name, fields })
+            .labelled("union")
+            .padded(),
+    )
 }
 
 /// Parses a type definition, which consists of a new type name and an existing type.
 pub(crate) fn type_definition<'src>()
 -> impl Parser<'src, &'src str, TypeDefinition, ErrorType<'src>> {
-    just("using")
-        .padded()
-        .ignore_then(identifier())
-        .then_ignore(equal())
-        .then(type_identifier())
-        .then_ignore(semicolon())
-        .map(|(new_type, r#type)| TypeDefinition { new_type, r#type })
-        .labelled("type definition")
-        .padded()
+    rule(
+        "type_definition",
+        just("using")
+            .padded()
+            .ignore_then(identifier())
+            .then_ignore(equal())
+            .then(type_identifier())
+            .then_ignore(semicolon())
+            .map(|(new_type, r#type)| TypeDefinition { new_type, r#type })
+            .labelled("type definition")
+            .padded(),
+    )
 }
 
 /// Parses a single definition, which can be an enumeration, structure, union, or type definition.
 pub(crate) fn definition<'src>() -> impl Parser<'src, &'src str, Definition, ErrorType<'src>> {
-    choice((
-        enumeration_definition().map(Definition::Enumeration),
-        structure_definition().map(Definition::Structure),
-        union_definition().map(Definition::Union),
-        type_definition().map(Definition::Type),
-    ))
-    .labelled("definition")
-    .padded()
+    rule(
+        "definition",
+        choice((
+            enumeration_definition().map(Definition::Enumeration),
+            structure_definition().map(Definition::Structure),
+            union_definition().map(Definition::Union),
+            type_definition().map(Definition::Type),
+        ))
+        .labelled("definition")
+        .padded(),
+    )
+}
+
+/// Parses an import statement, which consists of the `import` keyword and a
+/// double-quoted path to another meklang file, and returns the path. The path
+/// is sliced from the input and only converted to an owned `String` once, when
+/// it is handed to the AST.
+pub(crate) fn import_statement<'src>() -> impl Parser<'src, &'src str, String, ErrorType<'src>> {
+    rule(
+        "import_statement",
+        just("import")
+            .padded()
+            .ignore_then(
+                none_of('"')
+                    .repeated()
+                    .to_slice()
+                    .map(str::to_string)
+                    .delimited_by(just('"'), just('"')),
+            )
+            .then_ignore(semicolon())
+            .labelled("import")
+            .padded(),
+    )
 }
 
 /// Parses a comment which is the whole line starting with `#` and ending with a newline.
 pub(crate) fn comment<'src>() -> impl Parser<'src, &'src str, (), ErrorType<'src>> {
-    just('#')
-        .ignore_then(
-            any()
-                .filter(|c| *c != '\n' && *c != '\r')
-                .repeated()
-                .ignore_then(text::newline().or(end())),
-        )
-        .map(|_| ())
-        .labelled("comment")
-        .padded()
+    rule(
+        "comment",
+        just('#')
+            .ignore_then(
+                any()
+                    .filter(|c| *c != '\n' && *c != '\r')
+                    .repeated()
+                    .ignore_then(text::newline().or(end())),
+            )
+            .map(|_| ())
+            .labelled("comment")
+            .padded(),
+    )
+}
+
+/// A single top-level item of a protocol source, used while collecting the
+/// parsed [`Protocol`].
+#[derive(Clone)]
+enum ProtocolItem {
+    Import(String),
+    Definition(Definition),
+    Comment,
 }
 
-/// Parses the entire protocol, which consists of multiple definitions and comments
-/// that can be mixed (i.e. definition, comment, definition, definition, comment, etc.).
+/// Parses the entire protocol, which consists of multiple imports, definitions
+/// and comments that can be mixed (i.e. import, definition, comment,
+/// definition, definition, comment, etc.).
 pub(crate) fn protocol<'src>() -> impl Parser<'src, &'src str, Protocol, ErrorType<'src>> {
-    // Accept either a definition or a comment, and collect only definitions
-    choice((definition().map(Some), comment().to(None)))
+    rule(
+        "protocol",
+        choice((
+            import_statement().map(ProtocolItem::Import),
+            definition().map(ProtocolItem::Definition),
+            comment().to(ProtocolItem::Comment),
+        ))
         .repeated()
-        .collect::<Vec<Option<Definition>>>()
+        .collect::<Vec<ProtocolItem>>()
         .map(|items| {
-            let definitions = items.into_iter().flatten().collect();
-            Protocol { definitions }
+            let mut imports = Vec::new();
+            let mut definitions = Vec::new();
+            for item in items {
+                match item {
+                    ProtocolItem::Import(path) => imports.push(path),
+                    ProtocolItem::Definition(definition) => definitions.push(definition),
+                    ProtocolItem::Comment => {}
+                }
+            }
+            Protocol {
+                imports,
+                definitions,
+            }
         })
         .labelled("protocol")
-        .padded()
+        .padded(),
+    )
+}
+
+/// Cache key for the protocol parser. Building the combinator tree walks
+/// through dozens of sub-parsers, which is wasteful to repeat on every parse
+/// call, so the tree is built lazily once per thread and shared via
+/// [`parse_protocol_cached`]. The parser holds `Rc`s internally (from
+/// `boxed` and `recursive`), so the cache is thread-local rather than global.
+#[derive(Default)]
+struct ProtocolParser;
+
+impl Cached for ProtocolParser {
+    type Parser<'src> = Boxed<'src, 'src, &'src str, Protocol, ErrorType<'src>>;
+
+    fn make_parser<'src>(self) -> Self::Parser<'src> {
+        protocol().boxed()
+    }
+}
+
+thread_local! {
+    static PROTOCOL_PARSER: Cache<ProtocolParser> = Cache::default();
+}
+
+/// Parses `input` with the cached protocol parser. The cache erases the input
+/// lifetime, so the same parser instance is reused for every parse on the
+/// calling thread instead of rebuilding the combinator tree each time.
+pub(crate) fn parse_protocol_cached(input: &str) -> ParseResult<Protocol, RichError<'_>> {
+    PROTOCOL_PARSER.with(|cache| cache.get().parse(input))
 }
 
 #[cfg(test)]
@@ -705,9 +916,7 @@ mod tests {
         assert!(!result.has_errors() && result.has_output());
         assert_eq!(
             result.into_output().unwrap(),
-            Identifier {
-                name: "myIdentifier".to_string()
-            }
+            Identifier::new("myIdentifier")
         );
     }
 
@@ -717,9 +926,7 @@ mod tests {
         assert!(!result.has_errors() && result.has_output());
         assert_eq!(
             result.into_output().unwrap(),
-            Identifier {
-                name: "_myIdentifier".to_string()
-            }
+            Identifier::new("_myIdentifier")
         );
     }
 
@@ -729,9 +936,7 @@ mod tests {
         assert!(!result.has_errors() && result.has_output());
         assert_eq!(
             result.into_output().unwrap(),
-            Identifier {
-                name: "myIdentifier123".to_string()
-            }
+            Identifier::new("myIdentifier123")
         );
     }
 
@@ -1633,6 +1838,31 @@ mod tests {
         );
     }
 
+    #[test]
+    fn test_import_statement() {
+        let input = "import \"common/types.mek\";";
+        let result = import_statement().parse(input);
+        assert!(!result.has_errors() && result.has_output());
+        assert_eq!(result.into_output().unwrap(), "common/types.mek");
+    }
+
+    #[test]
+    fn test_import_statement_without_closing_quote() {
+        let input = "import \"common/types.mek;";
+        let result = import_statement().parse(input);
+        assert!(result.has_errors());
+    }
+
+    #[test]
+    fn test_protocol_collects_imports_and_definitions() {
+        let input = "import \"common.mek\";\nusing MyType = int32;\n";
+        let result = protocol().parse(input);
+        assert!(!result.has_errors() && result.has_output());
+        let protocol = result.into_output().unwrap();
+        assert_eq!(protocol.imports, vec!["common.mek"]);
+        assert_eq!(protocol.definitions.len(), 1);
+    }
+
     #[test]
     fn test_comment_starting_after_space() {
         let input = "# This is a comment\n";
@@ -1682,6 +1912,7 @@ union MyUnion {
         assert_eq!(
             result.into_output().unwrap(),
             Protocol {
+                imports: vec![],
                 definitions: vec![
                     Definition::Type(TypeDefinition {
                         new_type: Identifier::new("MyType"),
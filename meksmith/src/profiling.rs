@@ -0,0 +1,124 @@
+//! Per-rule parser instrumentation, enabled with the `profiling` feature.
+//!
+//! Every named grammar rule in the `parser` module is wrapped with a
+//! combinator that counts how often the rule runs, how much time it spends
+//! (including its sub-rules), and how often it fails and backtracks into an
+//! alternative. The counters are thread-local, matching the thread-local
+//! parser cache, so parses on different threads do not mix their numbers.
+//!
+//! The wrappers report a failed rule at the rule's entry point, which makes
+//! error messages less precise than in a default build: enable the feature
+//! to measure where the parser spends its time, not to report errors.
+//!
+//! Typical use on a pathological input:
+//!
+//! ```
+//! meksmith::profiling::reset();
+//! let _ = meksmith::parse_protocol_to_ast("using MyType = int32;");
+//! for stats in meksmith::profiling::report() {
+//!     println!(
+//!         "{}: {} invocations, {} backtracks, {:?}",
+//!         stats.rule, stats.invocations, stats.backtracks, stats.duration
+//!     );
+//! }
+//! ```
+
+use std::cell::RefCell;
+use std::collections::HashMap;
+use std::time::Duration;
+
+/// Collected counters of one grammar rule.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct RuleStats {
+    /// Name of the rule, i.e. the combinator function in the parser.
+    pub rule: &'static str,
+    /// How often the rule was run.
+    pub invocations: u64,
+    /// How often the rule failed, making the parser backtrack.
+    pub backtracks: u64,
+    /// Cumulative time spent in the rule, including its sub-rules.
+    pub duration: Duration,
+}
+
+thread_local! {
+    static STATS: RefCell<HashMap<&'static str, RuleStats>> = RefCell::new(HashMap::new());
+}
+
+/// Records one run of a rule; called by the instrumentation wrapper in the
+/// parser.
+pub(crate) fn record(rule: &'static str, duration: Duration, backtracked: bool) {
+    STATS.with(|stats| {
+        let mut stats = stats.borrow_mut();
+        let entry = stats.entry(rule).or_insert(RuleStats {
+            rule,
+            invocations: 0,
+            backtracks: 0,
+            duration: Duration::ZERO,
+        });
+        entry.invocations += 1;
+        entry.backtracks += u64::from(backtracked);
+        entry.duration += duration;
+    });
+}
+
+/// Clears the counters collected on the calling thread.
+pub fn reset() {
+    STATS.with(|stats| stats.borrow_mut().clear());
+}
+
+/// Returns the counters collected on the calling thread since the last
+/// [`reset`], most expensive rule first.
+pub fn report() -> Vec<RuleStats> {
+    STATS.with(|stats| {
+        let mut report: Vec<RuleStats> = stats.borrow().values().cloned().collect();
+        report.sort_by(|left, right| right.duration.cmp(&left.duration));
+        report
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_report_counts_rule_invocations() {
+        reset();
+        let result = crate::parse_protocol_to_ast("using MyType = int32;\n");
+        assert!(result.is_ok());
+
+        let report = report();
+        assert!(!report.is_empty());
+        let protocol = report
+            .iter()
+            .find(|stats| stats.rule == "protocol")
+            .expect("The protocol rule should have been recorded");
+        assert_eq!(protocol.invocations, 1);
+        let identifier = report
+            .iter()
+            .find(|stats| stats.rule == "identifier")
+            .expect("The identifier rule should have been recorded");
+        assert!(identifier.invocations >= 1);
+    }
+
+    #[test]
+    fn test_report_counts_backtracks() {
+        reset();
+        // An enumeration with a range field first fails the single-value
+        // alternative, so the parse must record at least one backtrack.
+        let result = crate::parse_protocol_to_ast("enum MyEnum {\n    Range = 1..3;\n};\n");
+        assert!(result.is_ok());
+
+        let single_value = report()
+            .into_iter()
+            .find(|stats| stats.rule == "enumeration_field_single_value")
+            .expect("The single value rule should have been recorded");
+        assert!(single_value.backtracks >= 1);
+    }
+
+    #[test]
+    fn test_reset_clears_the_counters() {
+        let _ = crate::parse_protocol_to_ast("using MyType = int32;\n");
+        reset();
+        assert!(report().is_empty());
+    }
+}
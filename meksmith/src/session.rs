@@ -0,0 +1,340 @@
+//! Incremental parsing support for meklang sources.
+//!
+//! [`ParseSession`] keeps the source split into top-level definition chunks,
+//! each ending at a `;` at brace depth zero. An edit only re-parses the chunks
+//! it touches and splices the result into the existing `Protocol`, so the
+//! per-edit cost is proportional to the edit instead of the whole file. This
+//! is what interactive callers (like the website editor) should use instead of
+//! calling [`parse_protocol_to_ast`] on every keystroke.
+//!
+//! [`parse_protocol_to_ast`]: crate::parse_protocol_to_ast
+
+use crate::ast::{Definition, Protocol};
+use crate::diagnostics::{Diagnostic, LineIndex, join_diagnostics};
+use crate::parser::parse_protocol_cached;
+
+use std::ops::Range;
+
+/// A single top-level chunk of the source: the byte range it occupies and the
+/// definitions parsed from it. A chunk usually holds exactly one definition,
+/// but comments between definitions belong to the following chunk and a
+/// trailing comment-only chunk holds none.
+#[derive(Debug, Clone)]
+struct Chunk {
+    range: Range<usize>,
+    imports: Vec<String>,
+    definitions: Vec<Definition>,
+}
+
+/// An incremental parsing session over a single meklang source.
+///
+/// Create one with [`ParseSession::new`], apply edits with
+/// [`ParseSession::update`], and read the current AST with
+/// [`ParseSession::protocol`].
+#[derive(Debug, Clone)]
+pub struct ParseSession {
+    source: String,
+    chunks: Vec<Chunk>,
+}
+
+impl ParseSession {
+    /// Parses the full input and returns a session ready for incremental updates.
+    pub fn new(input: &str) -> Result<Self, String> {
+        let mut session = ParseSession {
+            source: input.to_string(),
+            chunks: Vec::new(),
+        };
+        let ranges = scan_chunk_ranges(&session.source, 0);
+        session.replace_chunks(0, ranges)?;
+        Ok(session)
+    }
+
+    /// Replaces `range` of the source with `new_text` and re-parses only the
+    /// chunks the edit touches. Chunks after the edit are shifted in place and
+    /// their definitions are reused without re-parsing.
+    ///
+    /// On a parse error the source keeps the edit applied, the failing chunks
+    /// contribute no definitions, and the error message matches the format of
+    /// [`parse_protocol_to_ast`](crate::parse_protocol_to_ast).
+    pub fn update(&mut self, range: Range<usize>, new_text: &str) -> Result<(), String> {
+        let old_end = range.end;
+        let delta = new_text.len() as isize - range.len() as isize;
+
+        self.source.replace_range(range.clone(), new_text);
+
+        // The reparse window starts at the first chunk the edit touches and
+        // covers everything up to the first chunk boundary that still lines up
+        // with a boundary of the old chunk list (shifted by the edit's size
+        // change). Everything past that boundary is reused as-is.
+        let first_affected = self
+            .chunks
+            .iter()
+            .position(|chunk| chunk.range.end > range.start)
+            .unwrap_or(self.chunks.len());
+        let window_start = self
+            .chunks
+            .get(first_affected)
+            .map_or(self.source.len().min(range.start), |chunk| {
+                chunk.range.start
+            });
+
+        let edit_end_in_new_source = range.start + new_text.len();
+        let reusable: Vec<(usize, usize)> = self
+            .chunks
+            .iter()
+            .enumerate()
+            .skip(first_affected)
+            .filter(|(_, chunk)| chunk.range.start >= old_end)
+            .map(|(index, chunk)| ((chunk.range.start as isize + delta) as usize, index))
+            .collect();
+
+        let mut rescanned = Vec::new();
+        let mut resync_at = None;
+        let mut position = window_start;
+        while position < self.source.len() {
+            if position >= edit_end_in_new_source
+                && let Ok(found) = reusable.binary_search_by_key(&position, |(start, _)| *start)
+            {
+                resync_at = Some(reusable[found].1);
+                break;
+            }
+            let end = next_chunk_end(&self.source, position);
+            rescanned.push(position..end);
+            position = end;
+        }
+
+        let mut tail = match resync_at {
+            Some(old_index) => self.chunks.split_off(old_index),
+            None => Vec::new(),
+        };
+        for chunk in &mut tail {
+            chunk.range = ((chunk.range.start as isize + delta) as usize)
+                ..((chunk.range.end as isize + delta) as usize);
+        }
+
+        self.chunks.truncate(first_affected);
+        let result = self.replace_chunks(self.chunks.len(), rescanned);
+        self.chunks.extend(tail);
+        result
+    }
+
+    /// Returns the protocol assembled from all chunks, in source order.
+    pub fn protocol(&self) -> Protocol {
+        Protocol {
+            imports: self
+                .chunks
+                .iter()
+                .flat_map(|chunk| chunk.imports.iter().cloned())
+                .collect(),
+            definitions: self
+                .chunks
+                .iter()
+                .flat_map(|chunk| chunk.definitions.iter().cloned())
+                .collect(),
+        }
+    }
+
+    /// Returns the current source text, with all updates applied.
+    pub fn source(&self) -> &str {
+        &self.source
+    }
+
+    /// Parses `ranges` into chunks and appends them starting at `insert_at`.
+    /// Errors from all failing chunks are collected into a single message.
+    fn replace_chunks(
+        &mut self,
+        insert_at: usize,
+        ranges: Vec<Range<usize>>,
+    ) -> Result<(), String> {
+        let line_index = LineIndex::new(&self.source);
+        let mut diagnostics = Vec::new();
+
+        for range in ranges {
+            let text = &self.source[range.clone()];
+            let result = parse_protocol_cached(text);
+            let (imports, definitions) = match result.into_result() {
+                Ok(parsed) => (parsed.imports, parsed.definitions),
+                Err(errors) => {
+                    for error in errors {
+                        let span = range.start + error.span().start..range.start + error.span().end;
+                        let (line, column) = line_index.location(span.start);
+                        diagnostics.push(Diagnostic {
+                            span,
+                            line,
+                            column,
+                            message: error.to_string(),
+                        });
+                    }
+                    (Vec::new(), Vec::new())
+                }
+            };
+            self.chunks.push(Chunk {
+                range,
+                imports,
+                definitions,
+            });
+        }
+
+        debug_assert!(insert_at <= self.chunks.len());
+        if diagnostics.is_empty() {
+            Ok(())
+        } else {
+            Err(join_diagnostics(&diagnostics))
+        }
+    }
+}
+
+/// Splits `source` into top-level chunk ranges starting at `start`. Each chunk
+/// ends just after a `;` at brace depth zero; any trailing text (for example
+/// comments or an unterminated definition) forms a final chunk of its own.
+pub(crate) fn scan_chunk_ranges(source: &str, start: usize) -> Vec<Range<usize>> {
+    let mut ranges = Vec::new();
+    let mut position = start;
+    while position < source.len() {
+        let end = next_chunk_end(source, position);
+        ranges.push(position..end);
+        position = end;
+    }
+    ranges
+}
+
+/// Returns the end of the chunk starting at `start`: one past the next `;` at
+/// brace depth zero, or the end of the source if there is none. Semicolons and
+/// braces inside `#` comments are ignored.
+fn next_chunk_end(source: &str, start: usize) -> usize {
+    let mut depth: usize = 0;
+    let mut in_comment = false;
+    for (offset, byte) in source.as_bytes()[start..].iter().enumerate() {
+        match byte {
+            b'\n' => in_comment = false,
+            _ if in_comment => {}
+            b'#' => in_comment = true,
+            b'{' => depth += 1,
+            b'}' => depth = depth.saturating_sub(1),
+            b';' if depth == 0 => return start + offset + 1,
+            _ => {}
+        }
+    }
+    source.len()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::parse_protocol_to_ast;
+
+    static SOURCE: &str = "using MyType = int32[10];\n# comment\nenum MyEnum {\n    first = 1;\n    second = 2;\n};\nstruct MyStruct {\n    field: MyEnum;\n};\n";
+
+    #[test]
+    fn test_session_matches_full_parse() {
+        let session = ParseSession::new(SOURCE).expect("Parsing failed");
+        let full = parse_protocol_to_ast(SOURCE).expect("Parsing failed");
+        assert_eq!(session.protocol(), full);
+    }
+
+    #[test]
+    fn test_update_within_one_definition() {
+        let mut session = ParseSession::new(SOURCE).expect("Parsing failed");
+
+        // Replace the `first = 1;` value inside the enum with `first = 7;`.
+        let offset = SOURCE.find("first = 1").unwrap() + "first = ".len();
+        session
+            .update(offset..offset + 1, "7")
+            .expect("Update failed");
+
+        let expected_source = SOURCE.replace("first = 1", "first = 7");
+        assert_eq!(session.source(), expected_source);
+        assert_eq!(
+            session.protocol(),
+            parse_protocol_to_ast(&expected_source).expect("Parsing failed")
+        );
+    }
+
+    #[test]
+    fn test_update_reuses_following_chunks() {
+        let mut session = ParseSession::new(SOURCE).expect("Parsing failed");
+        let struct_chunk_index = session
+            .chunks
+            .iter()
+            .position(|chunk| SOURCE[chunk.range.clone()].contains("struct"))
+            .unwrap();
+        let struct_definitions_before = session.chunks[struct_chunk_index].definitions.clone();
+        let struct_range_before = session.chunks[struct_chunk_index].range.clone();
+
+        let inserted = "Renamed";
+        let offset = SOURCE.find("MyType").unwrap() + "MyType".len();
+        session
+            .update(offset..offset, inserted)
+            .expect("Update failed");
+
+        // The struct chunk after the edit is shifted by the insertion length
+        // and keeps its previously parsed definitions.
+        let struct_chunk = &session.chunks[struct_chunk_index];
+        assert_eq!(struct_chunk.definitions, struct_definitions_before);
+        assert_eq!(
+            struct_chunk.range,
+            struct_range_before.start + inserted.len()..struct_range_before.end + inserted.len()
+        );
+    }
+
+    #[test]
+    fn test_update_that_merges_definitions() {
+        let mut session = ParseSession::new(SOURCE).expect("Parsing failed");
+
+        // Deleting the semicolon after the type definition merges it with the
+        // following enum chunk and produces a parse error there.
+        let offset = SOURCE.find(';').unwrap();
+        let result = session.update(offset..offset + 1, "");
+        assert!(result.is_err());
+
+        // Restoring the semicolon brings the session back to the full parse.
+        session.update(offset..offset, ";").expect("Update failed");
+        assert_eq!(
+            session.protocol(),
+            parse_protocol_to_ast(SOURCE).expect("Parsing failed")
+        );
+    }
+
+    #[test]
+    fn test_update_appends_new_definition() {
+        let mut session = ParseSession::new(SOURCE).expect("Parsing failed");
+
+        let end = SOURCE.len();
+        session
+            .update(end..end, "using Extra = uint8;\n")
+            .expect("Update failed");
+
+        let expected_source = SOURCE.to_string() + "using Extra = uint8;\n";
+        assert_eq!(
+            session.protocol(),
+            parse_protocol_to_ast(&expected_source).expect("Parsing failed")
+        );
+    }
+
+    #[test]
+    fn test_update_with_error_reports_global_location() {
+        let mut session = ParseSession::new(SOURCE).expect("Parsing failed");
+
+        let offset = SOURCE.find("field: MyEnum").unwrap() + "field".len();
+        let result = session.update(offset..offset + 1, "");
+
+        assert!(result.is_err());
+        assert!(result.unwrap_err().starts_with("Parsing failed. Errors:"));
+    }
+
+    #[test]
+    fn test_scan_chunk_ranges_covers_whole_source() {
+        let ranges = scan_chunk_ranges(SOURCE, 0);
+        assert_eq!(ranges.first().unwrap().start, 0);
+        assert_eq!(ranges.last().unwrap().end, SOURCE.len());
+        for pair in ranges.windows(2) {
+            assert_eq!(pair[0].end, pair[1].start);
+        }
+    }
+
+    #[test]
+    fn test_next_chunk_end_ignores_semicolons_in_comments_and_braces() {
+        let source = "# comment with ; inside\nenum E { a = 1; };";
+        assert_eq!(next_chunk_end(source, 0), source.len());
+    }
+}
@@ -1,121 +1,148 @@
 use crate::ast::{
-    Definition, EnumerationDefinition, EnumerationField, Protocol, StructureDefinition,
-    TypeDefinition, TypeIdentifier, UnionDefinition, UnionField,
+    Attribute, Definition, EnumerationDefinition, EnumerationField, Protocol, StructureDefinition,
+    StructureField, TypeDefinition, TypeIdentifier, UnionDefinition, UnionField,
 };
 
-fn generate_enumeration_code(enumeration: &EnumerationDefinition) -> String {
-    let mut code = String::new();
-    code.push_str("typedef enum {\n");
+use std::fmt::Write;
+
+/// Emits an enumeration as a C `typedef enum`. A range field is compressed
+/// into `_first`/`_last` bound enumerators plus a `_CONTAINS` range-check
+/// macro instead of one enumerator per value, keeping the output O(ranges).
+fn emit_enumeration_code<W: Write>(
+    sink: &mut W,
+    enumeration: &EnumerationDefinition,
+) -> std::fmt::Result {
+    sink.write_str("typedef enum {\n")?;
     for field in &enumeration.fields {
         match field {
             EnumerationField::SingleValue { name, value } => {
-                code.push_str(&format!(
-                    "    {}_{} = {},\n",
+                writeln!(
+                    sink,
+                    "    {}_{} = {},",
                     enumeration.name.name, name.name, value
-                ));
+                )?;
             }
             EnumerationField::RangeOfValues { name, start, end } => {
                 if start == end {
-                    code.push_str(&format!(
-                        "    {}_{} = {},\n",
+                    writeln!(
+                        sink,
+                        "    {}_{} = {},",
                         enumeration.name.name, name.name, start
-                    ));
+                    )?;
                 } else {
-                    for i in *start..=*end {
-                        code.push_str(&format!(
-                            "    {}_{}_{} = {},\n",
-                            enumeration.name.name, name.name, i, i
-                        ));
-                    }
+                    writeln!(
+                        sink,
+                        "    {}_{}_first = {},",
+                        enumeration.name.name, name.name, start
+                    )?;
+                    writeln!(
+                        sink,
+                        "    {}_{}_last = {},",
+                        enumeration.name.name, name.name, end
+                    )?;
                 }
             }
         }
     }
-    code.push_str(&format!("}} {};\n\n", enumeration.name.name));
-    code
+    writeln!(sink, "}} {};", enumeration.name.name)?;
+    for field in &enumeration.fields {
+        if let EnumerationField::RangeOfValues { name, start, end } = field
+            && start != end
+        {
+            writeln!(
+                sink,
+                "#define {}_{}_CONTAINS(value) ((value) >= {}_{}_first && (value) <= {}_{}_last)",
+                to_macro_case(&enumeration.name.name),
+                to_macro_case(&name.name),
+                enumeration.name.name,
+                name.name,
+                enumeration.name.name,
+                name.name,
+            )?;
+        }
+    }
+    sink.write_char('\n')
 }
 
-fn generate_type_definition_code(type_definition: &TypeDefinition) -> String {
+fn emit_type_definition_code<W: Write>(
+    sink: &mut W,
+    type_definition: &TypeDefinition,
+) -> std::fmt::Result {
     match &type_definition.r#type {
         TypeIdentifier::StaticArray { r#type, size } => {
-            format!(
-                "typedef {} {}[{}];\n\n",
-                generate_type_identifier_code(r#type),
-                type_definition.new_type.name,
-                size
-            )
+            sink.write_str("typedef ")?;
+            emit_type_identifier_code(sink, r#type)?;
+            writeln!(sink, " {}[{}];\n", type_definition.new_type.name, size)
         }
         TypeIdentifier::DynamicArray { r#type } => {
-            format!(
-                "typedef {}* {};\n\n",
-                generate_type_identifier_code(r#type),
-                type_definition.new_type.name
-            )
+            sink.write_str("typedef ")?;
+            emit_type_identifier_code(sink, r#type)?;
+            writeln!(sink, "* {};\n", type_definition.new_type.name)
         }
         _ => {
-            let type_code = generate_type_identifier_code(&type_definition.r#type);
-            format!(
-                "typedef {} {};\n\n",
-                type_code, type_definition.new_type.name
-            )
+            sink.write_str("typedef ")?;
+            emit_type_identifier_code(sink, &type_definition.r#type)?;
+            writeln!(sink, " {};\n", type_definition.new_type.name)
         }
     }
 }
 
-fn generate_type_identifier_code(type_identifier: &TypeIdentifier) -> String {
+fn emit_type_identifier_code<W: Write>(
+    sink: &mut W,
+    type_identifier: &TypeIdentifier,
+) -> std::fmt::Result {
     match type_identifier {
-        TypeIdentifier::Integer8 => "int8_t".to_string(),
-        TypeIdentifier::Integer16 => "int16_t".to_string(),
-        TypeIdentifier::Integer32 => "int32_t".to_string(),
-        TypeIdentifier::Integer64 => "int64_t".to_string(),
-        TypeIdentifier::UnsignedInteger8 => "uint8_t".to_string(),
-        TypeIdentifier::UnsignedInteger16 => "uint16_t".to_string(),
-        TypeIdentifier::UnsignedInteger32 => "uint32_t".to_string(),
-        TypeIdentifier::UnsignedInteger64 => "uint64_t".to_string(),
-        TypeIdentifier::Float32 => "float".to_string(),
-        TypeIdentifier::Float64 => "double".to_string(),
-        TypeIdentifier::Bit => "bool".to_string(),
-        TypeIdentifier::Byte => "uint8_t".to_string(),
-        TypeIdentifier::UserDefined(identifier) => identifier.name.clone(),
+        TypeIdentifier::Integer8 => sink.write_str("int8_t"),
+        TypeIdentifier::Integer16 => sink.write_str("int16_t"),
+        TypeIdentifier::Integer32 => sink.write_str("int32_t"),
+        TypeIdentifier::Integer64 => sink.write_str("int64_t"),
+        TypeIdentifier::UnsignedInteger8 => sink.write_str("uint8_t"),
+        TypeIdentifier::UnsignedInteger16 => sink.write_str("uint16_t"),
+        TypeIdentifier::UnsignedInteger32 => sink.write_str("uint32_t"),
+        TypeIdentifier::UnsignedInteger64 => sink.write_str("uint64_t"),
+        TypeIdentifier::Float32 => sink.write_str("float"),
+        TypeIdentifier::Float64 => sink.write_str("double"),
+        TypeIdentifier::Bit => sink.write_str("bool"),
+        TypeIdentifier::Byte => sink.write_str("uint8_t"),
+        TypeIdentifier::UserDefined(identifier) => sink.write_str(&identifier.name),
         TypeIdentifier::StaticArray { r#type, .. } => {
-            // Only return the type, not the array part
-            generate_type_identifier_code(r#type)
+            // Only emit the type, not the array part
+            emit_type_identifier_code(sink, r#type)
         }
         TypeIdentifier::DynamicArray { r#type } => {
-            format!("{}*", generate_type_identifier_code(r#type))
+            emit_type_identifier_code(sink, r#type)?;
+            sink.write_str("*")
         }
     }
 }
 
-fn generate_structure_code(structure: &StructureDefinition) -> String {
-    let mut code = String::new();
-    code.push_str("typedef struct {\n");
+fn emit_structure_code<W: Write>(
+    sink: &mut W,
+    structure: &StructureDefinition,
+) -> std::fmt::Result {
+    sink.write_str("typedef struct {\n")?;
     for field in &structure.fields {
         match &field.r#type {
             TypeIdentifier::StaticArray { r#type, size } => {
-                code.push_str(&format!(
-                    "    {} {}[{}];\n",
-                    generate_type_identifier_code(r#type),
-                    field.name.name,
-                    size
-                ));
+                sink.write_str("    ")?;
+                emit_type_identifier_code(sink, r#type)?;
+                writeln!(sink, " {}[{}];", field.name.name, size)?;
             }
             _ => {
-                code.push_str(&format!(
-                    "    {} {};\n",
-                    generate_type_identifier_code(&field.r#type),
-                    field.name.name
-                ));
+                sink.write_str("    ")?;
+                emit_type_identifier_code(sink, &field.r#type)?;
+                writeln!(sink, " {};", field.name.name)?;
             }
         }
     }
-    code.push_str(&format!("}} {};\n\n", structure.name.name));
-    code
+    writeln!(sink, "}} {};\n", structure.name.name)
 }
 
-fn generate_union_code(union: &UnionDefinition) -> String {
-    let mut code = String::new();
-    code.push_str("typedef union {\n");
+/// Emits a union as a C `typedef union`. A range field becomes a single
+/// member; its discriminator bounds are emitted as `_FIRST_DISCRIMINATOR`/
+/// `_LAST_DISCRIMINATOR` constants with a `_CONTAINS` range-check macro.
+fn emit_union_code<W: Write>(sink: &mut W, union: &UnionDefinition) -> std::fmt::Result {
+    sink.write_str("typedef union {\n")?;
     for field in &union.fields {
         match field {
             UnionField::SingleValue { name, r#type, .. } => match r#type {
@@ -123,83 +150,989 @@ fn generate_union_code(union: &UnionDefinition) -> String {
                     r#type: inner_type,
                     size,
                 } => {
-                    code.push_str(&format!(
-                        "    {} {}[{}];\n",
-                        generate_type_identifier_code(inner_type),
-                        name.name,
-                        size
-                    ));
+                    sink.write_str("    ")?;
+                    emit_type_identifier_code(sink, inner_type)?;
+                    writeln!(sink, " {}[{}];", name.name, size)?;
+                }
+                _ => {
+                    sink.write_str("    ")?;
+                    emit_type_identifier_code(sink, r#type)?;
+                    writeln!(sink, " {};", name.name)?;
+                }
+            },
+            UnionField::RangeOfValues { name, r#type, .. } => match r#type {
+                TypeIdentifier::StaticArray {
+                    r#type: inner_type,
+                    size,
+                } => {
+                    sink.write_str("    ")?;
+                    emit_type_identifier_code(sink, inner_type)?;
+                    writeln!(sink, " {}[{}];", name.name, size)?;
                 }
                 _ => {
-                    code.push_str(&format!(
-                        "    {} {};\n",
-                        generate_type_identifier_code(r#type),
-                        name.name
-                    ));
+                    sink.write_str("    ")?;
+                    emit_type_identifier_code(sink, r#type)?;
+                    writeln!(sink, " {};", name.name)?;
                 }
             },
+        }
+    }
+    writeln!(sink, "}} {};", union.name.name)?;
+    for field in &union.fields {
+        if let UnionField::RangeOfValues {
+            name,
+            start_discriminator,
+            end_discriminator,
+            ..
+        } = field
+        {
+            let member_macro = format!(
+                "{}_{}",
+                to_macro_case(&union.name.name),
+                to_macro_case(&name.name)
+            );
+            writeln!(
+                sink,
+                "#define {member_macro}_FIRST_DISCRIMINATOR {start_discriminator}u"
+            )?;
+            writeln!(
+                sink,
+                "#define {member_macro}_LAST_DISCRIMINATOR {end_discriminator}u"
+            )?;
+            writeln!(
+                sink,
+                "#define {member_macro}_CONTAINS(discriminator) ((discriminator) >= {member_macro}_FIRST_DISCRIMINATOR && (discriminator) <= {member_macro}_LAST_DISCRIMINATOR)"
+            )?;
+        }
+    }
+    emit_union_dispatch_code(sink, union)?;
+    sink.write_char('\n')
+}
+
+/// Largest discriminator span lowered as a direct-indexed member table.
+/// A wider set would bloat the header, so it falls back to binary search.
+const MAX_DENSE_DISPATCH_SPAN: u64 = 512;
+
+/// Returns the `(first, last, member_index)` discriminator ranges of a
+/// union's fields, sorted by first discriminator. A single-value field is a
+/// range of one.
+fn union_dispatch_ranges(union: &UnionDefinition) -> Vec<(u64, u64, usize)> {
+    let mut ranges: Vec<(u64, u64, usize)> = union
+        .fields
+        .iter()
+        .enumerate()
+        .map(|(index, field)| match field {
+            UnionField::SingleValue { discriminator, .. } => {
+                (*discriminator, *discriminator, index)
+            }
             UnionField::RangeOfValues {
-                name,
-                r#type,
                 start_discriminator,
                 end_discriminator,
-            } => {
-                for i in *start_discriminator..=*end_discriminator {
-                    match r#type {
-                        TypeIdentifier::StaticArray {
-                            r#type: inner_type,
-                            size,
-                        } => {
-                            code.push_str(&format!(
-                                "    {} {}_{}[{}];\n",
-                                generate_type_identifier_code(inner_type),
-                                name.name,
-                                i,
-                                size
-                            ));
-                        }
-                        _ => {
-                            code.push_str(&format!(
-                                "    {} {}_{};\n",
-                                generate_type_identifier_code(r#type),
-                                name.name,
-                                i
-                            ));
-                        }
-                    }
-                }
+                ..
+            } => (*start_discriminator, *end_discriminator, index),
+        })
+        .collect();
+    ranges.sort_by_key(|(start, end, _)| (*start, *end));
+    ranges
+}
+
+/// Returns whether the discriminator set is dense enough for a
+/// direct-indexed table: the span must be bounded and at least a quarter
+/// occupied, otherwise the table is mostly `-1` padding.
+fn is_dense_dispatch(ranges: &[(u64, u64, usize)]) -> bool {
+    let min = ranges.first().map_or(0, |(start, _, _)| *start);
+    let max = ranges.iter().map(|(_, end, _)| *end).max().unwrap_or(0);
+    let span = max - min + 1;
+    let covered: u64 = ranges.iter().map(|(start, end, _)| end - start + 1).sum();
+    span <= MAX_DENSE_DISPATCH_SPAN && covered * 4 >= span
+}
+
+/// Emits `{Union}_member_index`, mapping a discriminator to the index of
+/// the union member it selects (or `-1`). The discriminator set is analyzed
+/// at generation time: a dense set becomes a direct-indexed table, a sparse
+/// one a binary search over its range bounds, so the first branch on every
+/// received packet costs one load or `log2(members)` compares.
+fn emit_union_dispatch_code<W: Write>(sink: &mut W, union: &UnionDefinition) -> std::fmt::Result {
+    let ranges = union_dispatch_ranges(union);
+    writeln!(
+        sink,
+        "static inline int {}_member_index(uint64_t discriminator) {{",
+        union.name.name
+    )?;
+
+    if is_dense_dispatch(&ranges) {
+        let min = ranges[0].0;
+        let max = ranges.iter().map(|(_, end, _)| *end).max().unwrap_or(0);
+        let span = max - min + 1;
+        let mut table = vec![-1i64; span as usize];
+        for (start, end, index) in &ranges {
+            for value in *start..=*end {
+                table[(value - min) as usize] = *index as i64;
             }
         }
+        let entries = table
+            .iter()
+            .map(i64::to_string)
+            .collect::<Vec<_>>()
+            .join(", ");
+        writeln!(
+            sink,
+            "    static const int16_t members[{span}] = {{{entries}}};"
+        )?;
+        if min > 0 {
+            writeln!(
+                sink,
+                "    if (discriminator < {min}u || discriminator > {max}u) {{"
+            )?;
+        } else {
+            writeln!(sink, "    if (discriminator > {max}u) {{")?;
+        }
+        writeln!(sink, "        return -1;")?;
+        writeln!(sink, "    }}")?;
+        if min > 0 {
+            writeln!(sink, "    return members[discriminator - {min}u];")?;
+        } else {
+            writeln!(sink, "    return members[discriminator];")?;
+        }
+    } else {
+        let count = ranges.len();
+        let firsts = ranges
+            .iter()
+            .map(|(start, _, _)| format!("{start}u"))
+            .collect::<Vec<_>>()
+            .join(", ");
+        let lasts = ranges
+            .iter()
+            .map(|(_, end, _)| format!("{end}u"))
+            .collect::<Vec<_>>()
+            .join(", ");
+        let members = ranges
+            .iter()
+            .map(|(_, _, index)| index.to_string())
+            .collect::<Vec<_>>()
+            .join(", ");
+        writeln!(
+            sink,
+            "    static const uint64_t first_discriminators[{count}] = {{{firsts}}};"
+        )?;
+        writeln!(
+            sink,
+            "    static const uint64_t last_discriminators[{count}] = {{{lasts}}};"
+        )?;
+        writeln!(
+            sink,
+            "    static const int16_t members[{count}] = {{{members}}};"
+        )?;
+        writeln!(sink, "    int low = 0;")?;
+        writeln!(sink, "    int high = {};", count - 1)?;
+        writeln!(sink, "    while (low <= high) {{")?;
+        writeln!(sink, "        int middle = low + (high - low) / 2;")?;
+        writeln!(
+            sink,
+            "        if (discriminator < first_discriminators[middle]) {{"
+        )?;
+        writeln!(sink, "            high = middle - 1;")?;
+        writeln!(
+            sink,
+            "        }} else if (discriminator > last_discriminators[middle]) {{"
+        )?;
+        writeln!(sink, "            low = middle + 1;")?;
+        writeln!(sink, "        }} else {{")?;
+        writeln!(sink, "            return members[middle];")?;
+        writeln!(sink, "        }}")?;
+        writeln!(sink, "    }}")?;
+        writeln!(sink, "    return -1;")?;
     }
-    code.push_str(&format!("}} {};\n\n", union.name.name));
-    code
+    writeln!(sink, "}}")
 }
 
-pub fn generate_c_code(protocol: &Protocol) -> String {
-    let mut code = String::new();
-    code.push_str("#include <stdint.h>\n#include <stdbool.h>\n\n");
+/// How a decoded field value is converted back to its C representation.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(crate) enum FieldValueKind {
+    Unsigned,
+    Signed,
+    Boolean,
+    Float,
+    UserDefined,
+}
 
-    for definition in &protocol.definitions {
-        match definition {
-            Definition::Enumeration(enumeration) => {
-                code.push_str(&generate_enumeration_code(enumeration));
+/// Precomputed bit layout of a single structure field. All offsets and widths
+/// are resolved at generation time, so the emitted encoder/decoder does
+/// straight-line shift/mask work with no runtime layout computation.
+/// Static arrays are laid out as `element_count` consecutive elements of
+/// `element_width` bits each.
+#[derive(Debug, Clone)]
+pub(crate) struct FieldLayout {
+    pub(crate) field_name: String,
+    pub(crate) c_type: String,
+    pub(crate) kind: FieldValueKind,
+    pub(crate) bit_offset: u64,
+    pub(crate) element_width: u64,
+    pub(crate) element_count: u64,
+}
+
+impl FieldLayout {
+    pub(crate) fn bit_width(&self) -> u64 {
+        self.element_width * self.element_count
+    }
+}
+
+/// Returns the bit width, value kind and C type of a built-in scalar type,
+/// or `None` for user-defined types and arrays.
+fn builtin_scalar_layout(
+    type_identifier: &TypeIdentifier,
+) -> Option<(u64, FieldValueKind, &'static str)> {
+    match type_identifier {
+        TypeIdentifier::Integer8 => Some((8, FieldValueKind::Signed, "int8_t")),
+        TypeIdentifier::Integer16 => Some((16, FieldValueKind::Signed, "int16_t")),
+        TypeIdentifier::Integer32 => Some((32, FieldValueKind::Signed, "int32_t")),
+        TypeIdentifier::Integer64 => Some((64, FieldValueKind::Signed, "int64_t")),
+        TypeIdentifier::UnsignedInteger8 => Some((8, FieldValueKind::Unsigned, "uint8_t")),
+        TypeIdentifier::UnsignedInteger16 => Some((16, FieldValueKind::Unsigned, "uint16_t")),
+        TypeIdentifier::UnsignedInteger32 => Some((32, FieldValueKind::Unsigned, "uint32_t")),
+        TypeIdentifier::UnsignedInteger64 => Some((64, FieldValueKind::Unsigned, "uint64_t")),
+        TypeIdentifier::Float32 => Some((32, FieldValueKind::Float, "float")),
+        TypeIdentifier::Float64 => Some((64, FieldValueKind::Float, "double")),
+        TypeIdentifier::Bit => Some((1, FieldValueKind::Boolean, "bool")),
+        TypeIdentifier::Byte => Some((8, FieldValueKind::Unsigned, "uint8_t")),
+        _ => None,
+    }
+}
+
+/// Returns the bit width requested by a `bits`/`bytes` attribute, if any.
+fn explicit_bit_width(field: &StructureField) -> Option<u64> {
+    field
+        .attributes
+        .iter()
+        .find_map(|attribute| match attribute {
+            Attribute::BitsSize { size } => Some(*size),
+            Attribute::BytesSize { size } => Some(size * 8),
+            Attribute::DiscriminatedBy { .. } => None,
+        })
+}
+
+/// Computes the layout of a single structure field, or `None` if its width
+/// cannot be determined at generation time.
+fn field_layout(field: &StructureField, bit_offset: u64) -> Option<FieldLayout> {
+    if let Some(width) = explicit_bit_width(field) {
+        if width == 0 || width > 64 {
+            return None;
+        }
+        let (kind, c_type) = match &field.r#type {
+            TypeIdentifier::UserDefined(identifier) => {
+                (FieldValueKind::UserDefined, identifier.name.to_string())
             }
-            Definition::Structure(structure) => {
-                code.push_str(&generate_structure_code(structure));
+            other => {
+                let (_, kind, c_type) = builtin_scalar_layout(other)?;
+                // A float cannot be truncated to an arbitrary bit width.
+                if kind == FieldValueKind::Float {
+                    return None;
+                }
+                (kind, c_type.to_string())
             }
-            Definition::Type(type_definition) => {
-                code.push_str(&generate_type_definition_code(type_definition));
+        };
+        return Some(FieldLayout {
+            field_name: field.name.name.to_string(),
+            c_type,
+            kind,
+            bit_offset,
+            element_width: width,
+            element_count: 1,
+        });
+    }
+
+    match &field.r#type {
+        TypeIdentifier::StaticArray { r#type, size } => {
+            let (element_width, kind, c_type) = builtin_scalar_layout(r#type)?;
+            Some(FieldLayout {
+                field_name: field.name.name.to_string(),
+                c_type: c_type.to_string(),
+                kind,
+                bit_offset,
+                element_width,
+                element_count: *size,
+            })
+        }
+        other => {
+            let (element_width, kind, c_type) = builtin_scalar_layout(other)?;
+            Some(FieldLayout {
+                field_name: field.name.name.to_string(),
+                c_type: c_type.to_string(),
+                kind,
+                bit_offset,
+                element_width,
+                element_count: 1,
+            })
+        }
+    }
+}
+
+/// Computes the full bit layout of a structure, or `None` if any field's width
+/// cannot be determined at generation time (user-defined types without a
+/// `bits`/`bytes` attribute, dynamic arrays). Only structures with a fully
+/// fixed layout get an encoder/decoder pair.
+pub(crate) fn structure_layout(structure: &StructureDefinition) -> Option<Vec<FieldLayout>> {
+    let mut layouts = Vec::with_capacity(structure.fields.len());
+    let mut bit_offset = 0;
+    for field in &structure.fields {
+        let layout = field_layout(field, bit_offset)?;
+        bit_offset += layout.bit_width();
+        layouts.push(layout);
+    }
+    Some(layouts)
+}
+
+/// One buffer byte touched by a field: how many value bits it holds (`mask` is
+/// their `bit_count`-wide mask), where they sit within the byte
+/// (`in_byte_shift`) and within the field value (`value_shift`). Fields are
+/// packed MSB-first, as is conventional for network protocol layouts.
+pub(crate) struct BytePacking {
+    pub(crate) byte_index: u64,
+    pub(crate) value_shift: u64,
+    pub(crate) in_byte_shift: u64,
+    pub(crate) mask: u64,
+}
+
+/// Splits a field at `bit_offset` of `bit_width` bits into the per-byte
+/// shift/mask constants used by the emitted straight-line code.
+pub(crate) fn byte_packings(bit_offset: u64, bit_width: u64) -> Vec<BytePacking> {
+    let mut packings = Vec::new();
+    let end = bit_offset + bit_width;
+    let mut byte_index = bit_offset / 8;
+    while byte_index * 8 < end {
+        let chunk_start = bit_offset.max(byte_index * 8);
+        let chunk_end = end.min(byte_index * 8 + 8);
+        let bit_count = chunk_end - chunk_start;
+        let highest_bit_in_byte = 7 - (chunk_start - byte_index * 8);
+        packings.push(BytePacking {
+            byte_index,
+            value_shift: end - chunk_end,
+            in_byte_shift: highest_bit_in_byte + 1 - bit_count,
+            mask: (1u64 << bit_count) - 1,
+        });
+        byte_index += 1;
+    }
+    packings
+}
+
+/// Converts a type name like `MyStruct` to the `my_struct` form used in
+/// generated function names.
+pub(crate) fn to_snake_case(name: &str) -> String {
+    let mut snake = String::with_capacity(name.len() + 4);
+    for (i, c) in name.chars().enumerate() {
+        if c.is_uppercase() {
+            if i > 0 && !snake.ends_with('_') {
+                snake.push('_');
             }
-            Definition::Union(union) => {
-                code.push_str(&generate_union_code(union));
+            snake.extend(c.to_lowercase());
+        } else {
+            snake.push(c);
+        }
+    }
+    snake
+}
+
+/// Converts a name like `MyStruct` to the `MY_STRUCT` form used in generated
+/// layout constants.
+fn to_macro_case(name: &str) -> String {
+    to_snake_case(name).to_uppercase()
+}
+
+/// Emits one encode statement block for a single element of a field.
+fn emit_encode_element<W: Write>(
+    sink: &mut W,
+    layout: &FieldLayout,
+    access: &str,
+    bit_offset: u64,
+) -> std::fmt::Result {
+    sink.write_str("    {\n")?;
+    match (layout.kind, layout.element_width) {
+        (FieldValueKind::Float, 32) => {
+            writeln!(sink, "        uint32_t value_bits;")?;
+            writeln!(
+                sink,
+                "        memcpy(&value_bits, &{access}, sizeof(value_bits));"
+            )?;
+            writeln!(sink, "        const uint64_t value = (uint64_t)value_bits;")?;
+        }
+        (FieldValueKind::Float, _) => {
+            writeln!(sink, "        uint64_t value_bits;")?;
+            writeln!(
+                sink,
+                "        memcpy(&value_bits, &{access}, sizeof(value_bits));"
+            )?;
+            writeln!(sink, "        const uint64_t value = value_bits;")?;
+        }
+        _ => {
+            writeln!(sink, "        const uint64_t value = (uint64_t){access};")?;
+        }
+    }
+    for packing in byte_packings(bit_offset, layout.element_width) {
+        writeln!(
+            sink,
+            "        buffer[{}] |= (uint8_t)(((value >> {}) & {:#X}u) << {});",
+            packing.byte_index, packing.value_shift, packing.mask, packing.in_byte_shift
+        )?;
+    }
+    sink.write_str("    }\n")
+}
+
+/// Emits one decode statement block for a single element of a field.
+fn emit_decode_element<W: Write>(
+    sink: &mut W,
+    layout: &FieldLayout,
+    access: &str,
+    bit_offset: u64,
+) -> std::fmt::Result {
+    sink.write_str("    {\n")?;
+    writeln!(sink, "        uint64_t value = 0u;")?;
+    for packing in byte_packings(bit_offset, layout.element_width) {
+        writeln!(
+            sink,
+            "        value |= ((uint64_t)((buffer[{}] >> {}) & {:#X}u)) << {};",
+            packing.byte_index, packing.in_byte_shift, packing.mask, packing.value_shift
+        )?;
+    }
+    match (layout.kind, layout.element_width) {
+        (FieldValueKind::Boolean, _) => {
+            writeln!(sink, "        {access} = value != 0u;")?;
+        }
+        (FieldValueKind::Signed, 64) => {
+            writeln!(sink, "        {access} = (int64_t)value;")?;
+        }
+        (FieldValueKind::Signed, width) => {
+            let sign_bit = 1u64 << (width - 1);
+            writeln!(
+                sink,
+                "        {access} = ({})((int64_t)(value ^ {:#X}u) - (int64_t){:#X}u);",
+                layout.c_type, sign_bit, sign_bit
+            )?;
+        }
+        (FieldValueKind::Float, 32) => {
+            writeln!(sink, "        uint32_t value_bits = (uint32_t)value;")?;
+            writeln!(sink, "        float decoded;")?;
+            writeln!(
+                sink,
+                "        memcpy(&decoded, &value_bits, sizeof(decoded));"
+            )?;
+            writeln!(sink, "        {access} = decoded;")?;
+        }
+        (FieldValueKind::Float, _) => {
+            writeln!(sink, "        uint64_t value_bits = value;")?;
+            writeln!(sink, "        double decoded;")?;
+            writeln!(
+                sink,
+                "        memcpy(&decoded, &value_bits, sizeof(decoded));"
+            )?;
+            writeln!(sink, "        {access} = decoded;")?;
+        }
+        _ => {
+            writeln!(sink, "        {access} = ({})value;", layout.c_type)?;
+        }
+    }
+    sink.write_str("    }\n")
+}
+
+/// Returns whether an array field is one whole byte per element, starting on
+/// a byte boundary, so it can be moved with a single `memcpy` that compilers
+/// turn into vectorized copies. Wider elements keep the per-element
+/// shift/mask path, which is what makes the wire format endian-independent.
+fn is_bulk_copy_array(layout: &FieldLayout) -> bool {
+    layout.element_count > 1 && layout.element_width == 8 && layout.bit_offset.is_multiple_of(8)
+}
+
+/// Emits the layout constants and the `encode_*`/`decode_*` pair for a
+/// structure with a fully fixed bit layout. The encoder zeroes the output
+/// buffer and ORs each field into place; both functions return the number of
+/// bytes the structure occupies on the wire.
+fn emit_structure_codec_code<W: Write>(
+    sink: &mut W,
+    structure: &StructureDefinition,
+    layouts: &[FieldLayout],
+) -> std::fmt::Result {
+    let macro_prefix = to_macro_case(&structure.name.name);
+    let function_suffix = to_snake_case(&structure.name.name);
+    let total_bits: u64 = layouts.iter().map(FieldLayout::bit_width).sum();
+    let total_bytes = total_bits.div_ceil(8);
+
+    for layout in layouts {
+        let field_macro = to_macro_case(&layout.field_name);
+        writeln!(
+            sink,
+            "#define {macro_prefix}_{field_macro}_BIT_OFFSET {}u",
+            layout.bit_offset
+        )?;
+        writeln!(
+            sink,
+            "#define {macro_prefix}_{field_macro}_BIT_WIDTH {}u",
+            layout.bit_width()
+        )?;
+    }
+    writeln!(sink, "#define {macro_prefix}_BIT_SIZE {total_bits}u")?;
+    writeln!(sink, "#define {macro_prefix}_BYTE_SIZE {total_bytes}u")?;
+
+    // Tie the layout constants to the typedef: every field's storage must be
+    // at least as wide as its wire width (also true for arrays, whose storage
+    // is element count times element storage), and the last field must end
+    // exactly at the wire size. Any drift between the struct and the
+    // constants then fails at compile time instead of corrupting packets.
+    for layout in layouts {
+        let field_macro = to_macro_case(&layout.field_name);
+        writeln!(
+            sink,
+            "_Static_assert(sizeof((({}*)0)->{}) * 8u >= {macro_prefix}_{field_macro}_BIT_WIDTH, \"{} is narrower than its wire width\");",
+            structure.name.name, layout.field_name, layout.field_name
+        )?;
+    }
+    if let Some(last) = layouts.last() {
+        let field_macro = to_macro_case(&last.field_name);
+        writeln!(
+            sink,
+            "_Static_assert({macro_prefix}_{field_macro}_BIT_OFFSET + {macro_prefix}_{field_macro}_BIT_WIDTH == {macro_prefix}_BIT_SIZE, \"field layout must cover the wire size\");"
+        )?;
+    }
+    sink.write_str("\n")?;
+
+    writeln!(
+        sink,
+        "static inline size_t encode_{function_suffix}(const {}* input, uint8_t* buffer) {{",
+        structure.name.name
+    )?;
+    writeln!(sink, "    memset(buffer, 0, {macro_prefix}_BYTE_SIZE);")?;
+    for layout in layouts {
+        if is_bulk_copy_array(layout) {
+            writeln!(
+                sink,
+                "    memcpy(buffer + {}, input->{}, {}u);",
+                layout.bit_offset / 8,
+                layout.field_name,
+                layout.element_count
+            )?;
+            continue;
+        }
+        for element in 0..layout.element_count {
+            let access = if layout.element_count == 1 {
+                format!("input->{}", layout.field_name)
+            } else {
+                format!("input->{}[{}]", layout.field_name, element)
+            };
+            let bit_offset = layout.bit_offset + element * layout.element_width;
+            emit_encode_element(sink, layout, &access, bit_offset)?;
+        }
+    }
+    writeln!(sink, "    return {macro_prefix}_BYTE_SIZE;")?;
+    sink.write_str("}\n\n")?;
+
+    writeln!(
+        sink,
+        "static inline size_t decode_{function_suffix}({}* output, const uint8_t* buffer) {{",
+        structure.name.name
+    )?;
+    for layout in layouts {
+        if is_bulk_copy_array(layout) {
+            writeln!(
+                sink,
+                "    memcpy(output->{}, buffer + {}, {}u);",
+                layout.field_name,
+                layout.bit_offset / 8,
+                layout.element_count
+            )?;
+            continue;
+        }
+        for element in 0..layout.element_count {
+            let access = if layout.element_count == 1 {
+                format!("output->{}", layout.field_name)
+            } else {
+                format!("output->{}[{}]", layout.field_name, element)
+            };
+            let bit_offset = layout.bit_offset + element * layout.element_width;
+            emit_decode_element(sink, layout, &access, bit_offset)?;
+        }
+    }
+    writeln!(sink, "    return {macro_prefix}_BYTE_SIZE;")?;
+    sink.write_str("}\n\n")
+}
+
+/// Bit layout of a trailing dynamic array: a fixed prefix of `bit_offset`
+/// bits followed by elements of `element_width` bits until the end of the
+/// receive buffer.
+struct DynamicArrayLayout {
+    field_name: String,
+    c_type: String,
+    kind: FieldValueKind,
+    bit_offset: u64,
+    element_width: u64,
+}
+
+/// Computes the layout of a structure whose last field is a dynamic array of
+/// a built-in scalar and whose other fields are all fixed, or `None`. Such a
+/// structure has no fixed-size codec, but its trailing array can still be
+/// decoded in place from the receive buffer.
+fn trailing_dynamic_array_layout(
+    structure: &StructureDefinition,
+) -> Option<(Vec<FieldLayout>, DynamicArrayLayout)> {
+    let (last, prefix_fields) = structure.fields.split_last()?;
+    let TypeIdentifier::DynamicArray { r#type } = &last.r#type else {
+        return None;
+    };
+    let (element_width, kind, c_type) = builtin_scalar_layout(r#type)?;
+
+    let mut prefix = Vec::with_capacity(prefix_fields.len());
+    let mut bit_offset = 0;
+    for field in prefix_fields {
+        let layout = field_layout(field, bit_offset)?;
+        bit_offset += layout.bit_width();
+        prefix.push(layout);
+    }
+    Some((
+        prefix,
+        DynamicArrayLayout {
+            field_name: last.name.name.to_string(),
+            c_type: c_type.to_string(),
+            kind,
+            bit_offset,
+            element_width,
+        },
+    ))
+}
+
+/// Emits the in-place decode helpers for a structure with a trailing dynamic
+/// array, so the whole message decodes with zero copies and allocations.
+/// When the array starts byte-aligned and its elements are single bytes, a
+/// `(pointer, length)` view aliasing the receive buffer is emitted; any other
+/// element layout gets an iterator-style cursor whose `_next` function
+/// decodes one element per call.
+fn emit_dynamic_array_view_code<W: Write>(
+    sink: &mut W,
+    structure: &StructureDefinition,
+    array: &DynamicArrayLayout,
+) -> std::fmt::Result {
+    let struct_name = &structure.name.name;
+    let function_prefix = format!(
+        "{}_{}",
+        to_snake_case(struct_name),
+        to_snake_case(&array.field_name)
+    );
+    let macro_prefix = format!(
+        "{}_{}",
+        to_macro_case(struct_name),
+        to_macro_case(&array.field_name)
+    );
+
+    writeln!(
+        sink,
+        "#define {macro_prefix}_BIT_OFFSET {}u",
+        array.bit_offset
+    )?;
+    writeln!(
+        sink,
+        "#define {macro_prefix}_ELEMENT_BIT_WIDTH {}u",
+        array.element_width
+    )?;
+
+    if array.bit_offset.is_multiple_of(8) && array.element_width == 8 {
+        let byte_offset = array.bit_offset / 8;
+        writeln!(sink, "#define {macro_prefix}_BYTE_OFFSET {byte_offset}u")?;
+        sink.write_str("\n")?;
+        writeln!(sink, "typedef struct {{")?;
+        writeln!(sink, "    const uint8_t* data;")?;
+        writeln!(sink, "    size_t length;")?;
+        writeln!(sink, "}} {struct_name}_{}_view;", array.field_name)?;
+        sink.write_str("\n")?;
+        writeln!(
+            sink,
+            "static inline {struct_name}_{}_view {function_prefix}_view(const uint8_t* buffer, size_t buffer_length) {{",
+            array.field_name
+        )?;
+        writeln!(sink, "    {struct_name}_{}_view view;", array.field_name)?;
+        writeln!(sink, "    view.data = buffer + {macro_prefix}_BYTE_OFFSET;")?;
+        // Clamp instead of subtracting blindly: on a buffer shorter than the
+        // fixed prefix the unsigned subtraction would wrap to a huge length.
+        writeln!(
+            sink,
+            "    view.length = buffer_length < {macro_prefix}_BYTE_OFFSET ? 0 : buffer_length - {macro_prefix}_BYTE_OFFSET;"
+        )?;
+        writeln!(sink, "    return view;")?;
+        writeln!(sink, "}}")?;
+        return sink.write_str("\n");
+    }
+
+    sink.write_str("\n")?;
+    writeln!(sink, "typedef struct {{")?;
+    writeln!(sink, "    const uint8_t* buffer;")?;
+    writeln!(sink, "    size_t bit_offset;")?;
+    writeln!(sink, "    size_t bit_end;")?;
+    writeln!(sink, "}} {struct_name}_{}_cursor;", array.field_name)?;
+    sink.write_str("\n")?;
+    writeln!(
+        sink,
+        "static inline {struct_name}_{}_cursor {function_prefix}_cursor(const uint8_t* buffer, size_t buffer_length) {{",
+        array.field_name
+    )?;
+    writeln!(
+        sink,
+        "    {struct_name}_{}_cursor cursor;",
+        array.field_name
+    )?;
+    writeln!(sink, "    cursor.buffer = buffer;")?;
+    writeln!(sink, "    cursor.bit_offset = {macro_prefix}_BIT_OFFSET;")?;
+    writeln!(sink, "    cursor.bit_end = buffer_length * 8u;")?;
+    writeln!(sink, "    return cursor;")?;
+    writeln!(sink, "}}")?;
+    sink.write_str("\n")?;
+    writeln!(
+        sink,
+        "static inline bool {function_prefix}_next({struct_name}_{}_cursor* cursor, {}* element) {{",
+        array.field_name, array.c_type
+    )?;
+    writeln!(
+        sink,
+        "    if (cursor->bit_offset + {macro_prefix}_ELEMENT_BIT_WIDTH > cursor->bit_end) {{"
+    )?;
+    writeln!(sink, "        return false;")?;
+    writeln!(sink, "    }}")?;
+    writeln!(sink, "    uint64_t value = 0u;")?;
+    writeln!(sink, "    size_t bit = cursor->bit_offset;")?;
+    writeln!(
+        sink,
+        "    size_t remaining = {macro_prefix}_ELEMENT_BIT_WIDTH;"
+    )?;
+    writeln!(sink, "    while (remaining > 0u) {{")?;
+    writeln!(sink, "        size_t available = 8u - bit % 8u;")?;
+    writeln!(
+        sink,
+        "        size_t take = available < remaining ? available : remaining;"
+    )?;
+    writeln!(
+        sink,
+        "        uint8_t chunk = (uint8_t)((cursor->buffer[bit / 8u] >> (available - take)) & ((1u << take) - 1u));"
+    )?;
+    writeln!(sink, "        value = (value << take) | chunk;")?;
+    writeln!(sink, "        bit += take;")?;
+    writeln!(sink, "        remaining -= take;")?;
+    writeln!(sink, "    }}")?;
+    writeln!(sink, "    cursor->bit_offset = bit;")?;
+    match (array.kind, array.element_width) {
+        (FieldValueKind::Boolean, _) => {
+            writeln!(sink, "    *element = value != 0u;")?;
+        }
+        (FieldValueKind::Signed, 64) => {
+            writeln!(sink, "    *element = (int64_t)value;")?;
+        }
+        (FieldValueKind::Signed, width) => {
+            let sign_bit = 1u64 << (width - 1);
+            writeln!(
+                sink,
+                "    *element = ({})((int64_t)(value ^ {:#X}u) - (int64_t){:#X}u);",
+                array.c_type, sign_bit, sign_bit
+            )?;
+        }
+        (FieldValueKind::Float, 32) => {
+            writeln!(sink, "    uint32_t value_bits = (uint32_t)value;")?;
+            writeln!(sink, "    memcpy(element, &value_bits, sizeof(*element));")?;
+        }
+        (FieldValueKind::Float, _) => {
+            writeln!(sink, "    uint64_t value_bits = value;")?;
+            writeln!(sink, "    memcpy(element, &value_bits, sizeof(*element));")?;
+        }
+        _ => {
+            writeln!(sink, "    *element = ({})value;", array.c_type)?;
+        }
+    }
+    writeln!(sink, "    return true;")?;
+    writeln!(sink, "}}")?;
+    sink.write_str("\n")
+}
+
+/// Per-line overhead allowance used by the size estimation pre-pass: covers
+/// indentation, the type name, separators, digits, and the newline.
+const ESTIMATED_BYTES_PER_LINE: usize = 32;
+
+/// Estimates the size in bytes of the C code generated for a definition.
+/// The estimate is intentionally generous so that emitting into a
+/// `String::with_capacity` buffer does not reallocate.
+pub(crate) fn estimate_definition_size(definition: &Definition) -> usize {
+    let (name_length, lines) = match definition {
+        Definition::Enumeration(enumeration) => (
+            enumeration.name.name.len(),
+            enumeration
+                .fields
+                .iter()
+                .map(|field| match field {
+                    EnumerationField::SingleValue { name, .. } => {
+                        1 + name.name.len() / ESTIMATED_BYTES_PER_LINE
+                    }
+                    // Two bound enumerators plus a range-check macro that
+                    // names the enumeration and the field three times.
+                    EnumerationField::RangeOfValues { name, .. } => {
+                        5 + name.name.len() * 4 / ESTIMATED_BYTES_PER_LINE
+                    }
+                })
+                .sum::<usize>(),
+        ),
+        Definition::Structure(structure) => {
+            // A structure with a fixed layout also gets layout constants and an
+            // encoder/decoder pair of up to a dozen lines per field element.
+            let codec_lines = structure_layout(structure).map_or_else(
+                // A trailing dynamic array instead gets a fixed-size view or
+                // cursor helper of a few dozen lines.
+                || trailing_dynamic_array_layout(structure).map_or(0, |_| 40),
+                // The static asserts name the field three times, so grant
+                // them a generous three lines each.
+                |layouts| {
+                    layouts
+                        .iter()
+                        .map(|layout| layout.element_count as usize * 12 + 5)
+                        .sum::<usize>()
+                        + 9
+                },
+            );
+            (
+                structure.name.name.len(),
+                structure.fields.len() + codec_lines,
+            )
+        }
+        Definition::Union(union) => {
+            // The dispatch helper adds a fixed body plus either a span-sized
+            // member table or three range tables of one entry per field.
+            let ranges = union_dispatch_ranges(union);
+            let dispatch_lines = if is_dense_dispatch(&ranges) {
+                let span = ranges.iter().map(|(_, end, _)| *end).max().unwrap_or(0)
+                    - ranges.first().map_or(0, |(start, _, _)| *start)
+                    + 1;
+                8 + span as usize / 4
+            } else {
+                16 + union.fields.len()
+            };
+            (
+                union.name.name.len(),
+                union
+                    .fields
+                    .iter()
+                    .map(|field| match field {
+                        UnionField::SingleValue { .. } => 1,
+                        // One member plus bounds constants and a range-check
+                        // macro that names the union and the field five times.
+                        UnionField::RangeOfValues { name, .. } => {
+                            9 + name.name.len() * 7 / ESTIMATED_BYTES_PER_LINE
+                        }
+                    })
+                    .sum::<usize>()
+                    + dispatch_lines,
+            )
+        }
+        Definition::Type(type_definition) => (type_definition.new_type.name.len(), 1),
+    };
+
+    // Opening and closing lines plus one allowance per emitted field line,
+    // with the definition name appearing on every line in the worst case
+    // (enumerator names are prefixed with it).
+    (lines + 2) * (ESTIMATED_BYTES_PER_LINE + name_length)
+}
+
+/// Estimates the total size in bytes of the C code generated for a protocol,
+/// including the file header.
+fn estimate_c_code_size(protocol: &Protocol) -> usize {
+    protocol
+        .definitions
+        .iter()
+        .map(estimate_definition_size)
+        .sum::<usize>()
+        + C_CODE_HEADER.len()
+}
+
+static C_CODE_HEADER: &str = "#include <stdint.h>\n#include <stdbool.h>\n\n";
+
+/// Header used when encoders/decoders are emitted: `stddef.h` for `size_t`
+/// and `string.h` for `memset`/`memcpy`.
+static C_CODEC_HEADER: &str =
+    "#include <stdint.h>\n#include <stdbool.h>\n#include <stddef.h>\n#include <string.h>\n\n";
+
+/// Emits the C code for a whole protocol into any [`std::fmt::Write`] sink,
+/// without building intermediate per-definition strings. Use this to stream
+/// output into an existing buffer or writer; [`generate_c_code`] wraps it for
+/// the common in-memory case.
+pub fn emit_c_code<W: Write>(sink: &mut W, protocol: &Protocol) -> std::fmt::Result {
+    sink.write_str(code_header(protocol))?;
+
+    for definition in &protocol.definitions {
+        emit_definition_code(sink, definition)?;
+    }
+    Ok(())
+}
+
+/// Returns the include header for a protocol: the codec header when at least
+/// one structure gets encoders, decoders, or dynamic array views.
+pub(crate) fn code_header(protocol: &Protocol) -> &'static str {
+    let has_codecs = protocol.definitions.iter().any(|definition| {
+        matches!(definition, Definition::Structure(structure)
+            if structure_layout(structure).is_some()
+                || trailing_dynamic_array_layout(structure).is_some())
+    });
+    if has_codecs {
+        C_CODEC_HEADER
+    } else {
+        C_CODE_HEADER
+    }
+}
+
+/// Emits the C code for a single definition into the sink.
+pub(crate) fn emit_definition_code<W: Write>(
+    sink: &mut W,
+    definition: &Definition,
+) -> std::fmt::Result {
+    match definition {
+        Definition::Enumeration(enumeration) => emit_enumeration_code(sink, enumeration),
+        Definition::Structure(structure) => {
+            emit_structure_code(sink, structure)?;
+            if let Some(layouts) = structure_layout(structure) {
+                emit_structure_codec_code(sink, structure, &layouts)?;
+            } else if let Some((_, array)) = trailing_dynamic_array_layout(structure) {
+                emit_dynamic_array_view_code(sink, structure, &array)?;
             }
+            Ok(())
         }
+        Definition::Type(type_definition) => emit_type_definition_code(sink, type_definition),
+        Definition::Union(union) => emit_union_code(sink, union),
+    }
+}
+
+pub fn generate_c_code(protocol: &Protocol) -> String {
+    let mut code = String::with_capacity(estimate_c_code_size(protocol));
+    emit_c_code(&mut code, protocol).expect("writing to a String cannot fail");
+    code
+}
+
+/// Generates the C code for a protocol by smithing each definition into its
+/// own buffer on a rayon worker pool and concatenating the buffers in input
+/// order, so the output is byte-for-byte identical to [`generate_c_code`].
+/// Worthwhile for batch generation over many or large protocols; for a single
+/// small protocol the serial path is usually faster.
+#[cfg(feature = "parallel")]
+pub fn generate_c_code_parallel(protocol: &Protocol) -> String {
+    use rayon::prelude::*;
+
+    let pieces: Vec<String> = protocol
+        .definitions
+        .par_iter()
+        .map(|definition| {
+            let mut piece = String::with_capacity(estimate_definition_size(definition));
+            emit_definition_code(&mut piece, definition).expect("writing to a String cannot fail");
+            piece
+        })
+        .collect();
+
+    let mut code = String::with_capacity(estimate_c_code_size(protocol));
+    code.push_str(code_header(protocol));
+    for piece in pieces {
+        code.push_str(&piece);
     }
     code
 }
 
 pub fn generate_c_code_from_string(input: &str) -> Result<String, String> {
-    let protocol = crate::parse_protocol_to_ast(input)?;
+    let protocol = crate::parse_protocol_to_ast(input)
+        .map_err(|diagnostics| crate::diagnostics::join_diagnostics(&diagnostics))?;
     let sorted = crate::ast::sort_protocol_by_dependencies(&protocol)?;
     Ok(generate_c_code(&sorted))
 }
@@ -210,14 +1143,29 @@ pub fn generate_from_file(file_path: &str) -> Result<String, String> {
     Ok(generate_c_code(&sorted))
 }
 
+/// Whether [`generate_from_file_to_file`] wrote the output file or left a
+/// byte-identical one untouched, so callers can log cache hits.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum WriteOutcome {
+    Written,
+    Unchanged,
+}
+
+/// Generates C code from the input file into the output file. When the
+/// output file already holds byte-identical content it is left untouched,
+/// keeping its mtime stable so downstream build systems do not recompile
+/// everything that includes it.
 pub fn generate_from_file_to_file(
     input_file_path: &str,
     output_file_path: &str,
-) -> Result<(), String> {
+) -> Result<WriteOutcome, String> {
     let c_code = generate_from_file(input_file_path)?;
+    if std::fs::read_to_string(output_file_path).is_ok_and(|existing| existing == c_code) {
+        return Ok(WriteOutcome::Unchanged);
+    }
     std::fs::write(output_file_path, c_code)
         .map_err(|e| format!("Failed to write to file: {e}"))?;
-    Ok(())
+    Ok(WriteOutcome::Written)
 }
 
 #[cfg(test)]
@@ -277,12 +1225,11 @@ typedef int32_t BuiltInType;
 
 typedef enum {
     MyEnum_Value = 1,
-    MyEnum_Range_2 = 2,
-    MyEnum_Range_3 = 3,
-    MyEnum_Range_4 = 4,
-    MyEnum_Range_5 = 5,
+    MyEnum_Range_first = 2,
+    MyEnum_Range_last = 5,
     MyEnum_RangeOneValue = 6,
 } MyEnum;
+#define MY_ENUM_RANGE_CONTAINS(value) ((value) >= MyEnum_Range_first && (value) <= MyEnum_Range_last)
 
 typedef MyEnum UserDefinedType;
 
@@ -318,14 +1265,380 @@ typedef union {
     MyEnum field2;
     uint64_t field3[10];
     MyStruct field4;
-    uint16_t reserved_4;
-    uint16_t reserved_5;
-    uint16_t reserved_6;
-    uint16_t static_array_7[10];
-    uint16_t static_array_8[10];
+    uint16_t reserved;
+    uint16_t static_array[10];
 } MyUnion;
+#define MY_UNION_RESERVED_FIRST_DISCRIMINATOR 4u
+#define MY_UNION_RESERVED_LAST_DISCRIMINATOR 6u
+#define MY_UNION_RESERVED_CONTAINS(discriminator) ((discriminator) >= MY_UNION_RESERVED_FIRST_DISCRIMINATOR && (discriminator) <= MY_UNION_RESERVED_LAST_DISCRIMINATOR)
+#define MY_UNION_STATIC_ARRAY_FIRST_DISCRIMINATOR 7u
+#define MY_UNION_STATIC_ARRAY_LAST_DISCRIMINATOR 8u
+#define MY_UNION_STATIC_ARRAY_CONTAINS(discriminator) ((discriminator) >= MY_UNION_STATIC_ARRAY_FIRST_DISCRIMINATOR && (discriminator) <= MY_UNION_STATIC_ARRAY_LAST_DISCRIMINATOR)
+static inline int MyUnion_member_index(uint64_t discriminator) {
+    static const int16_t members[9] = {0, 1, 2, 3, 4, 4, 4, 5, 5};
+    if (discriminator > 8u) {
+        return -1;
+    }
+    return members[discriminator];
+}
+
+"#;
+
+    #[test]
+    fn test_layout_static_asserts_cover_arrays() {
+        let input = r#"
+struct Frame {
+    kind: uint16;
+    mac: byte[6];
+};
+"#;
+        let output = generate_c_code_from_string(input).unwrap();
+        assert!(output.contains(
+            "_Static_assert(sizeof(((Frame*)0)->mac) * 8u >= FRAME_MAC_BIT_WIDTH, \"mac is narrower than its wire width\");"
+        ));
+        assert!(output.contains(
+            "_Static_assert(FRAME_MAC_BIT_OFFSET + FRAME_MAC_BIT_WIDTH == FRAME_BIT_SIZE, \"field layout must cover the wire size\");"
+        ));
+    }
+
+    #[test]
+    fn test_byte_array_encodes_and_decodes_with_memcpy() {
+        let input = r#"
+struct Frame {
+    kind: uint16;
+    mac: byte[6];
+    crc: uint32;
+};
+"#;
+        let output = generate_c_code_from_string(input).unwrap();
+        assert!(output.contains("    memcpy(buffer + 2, input->mac, 6u);"));
+        assert!(output.contains("    memcpy(output->mac, buffer + 2, 6u);"));
+        assert!(!output.contains("input->mac[0]"));
+        assert!(!output.contains("output->mac[0]"));
+    }
+
+    #[test]
+    fn test_unaligned_byte_array_keeps_the_per_element_path() {
+        let input = r#"
+struct Unaligned {
+    [bits = 4] version: uint8;
+    payload: byte[4];
+};
+"#;
+        let output = generate_c_code_from_string(input).unwrap();
+        assert!(!output.contains("memcpy(buffer + "));
+        assert!(output.contains("input->payload[0]"));
+        assert!(output.contains("output->payload[3]"));
+    }
 
+    #[test]
+    fn test_multi_byte_element_array_keeps_the_per_element_path() {
+        // uint16 elements are serialized MSB-first, so a memcpy would only be
+        // correct on big-endian hosts.
+        let input = r#"
+struct Samples {
+    values: uint16[4];
+};
+"#;
+        let output = generate_c_code_from_string(input).unwrap();
+        assert!(!output.contains("memcpy(buffer + "));
+        assert!(output.contains("input->values[0]"));
+    }
+
+    #[test]
+    fn test_trailing_byte_array_decodes_as_a_buffer_view() {
+        let input = r#"
+struct Packet {
+    kind: uint16;
+    payload: byte[];
+};
+"#;
+        let output = generate_c_code_from_string(input).unwrap();
+        assert!(output.contains("#define PACKET_PAYLOAD_BYTE_OFFSET 2u"));
+        assert!(output.contains("} Packet_payload_view;"));
+        assert!(output.contains(
+            "static inline Packet_payload_view packet_payload_view(const uint8_t* buffer, size_t buffer_length) {"
+        ));
+        assert!(output.contains("    view.data = buffer + PACKET_PAYLOAD_BYTE_OFFSET;"));
+        // A buffer shorter than the fixed prefix yields an empty view instead
+        // of wrapping the unsigned subtraction.
+        assert!(output.contains(
+            "    view.length = buffer_length < PACKET_PAYLOAD_BYTE_OFFSET ? 0 : buffer_length - PACKET_PAYLOAD_BYTE_OFFSET;"
+        ));
+        assert!(!output.contains("_cursor"));
+    }
+
+    #[test]
+    fn test_trailing_packed_array_decodes_through_a_cursor() {
+        let input = r#"
+struct Samples {
+    [bits = 4] header: uint8;
+    values: int16[];
+};
 "#;
+        let output = generate_c_code_from_string(input).unwrap();
+        assert!(output.contains("#define SAMPLES_VALUES_BIT_OFFSET 4u"));
+        assert!(output.contains("#define SAMPLES_VALUES_ELEMENT_BIT_WIDTH 16u"));
+        assert!(output.contains("} Samples_values_cursor;"));
+        assert!(output.contains(
+            "static inline bool samples_values_next(Samples_values_cursor* cursor, int16_t* element) {"
+        ));
+        assert!(
+            output.contains(
+                "    *element = (int16_t)((int64_t)(value ^ 0x8000u) - (int64_t)0x8000u);"
+            )
+        );
+        assert!(!output.contains("_view"));
+    }
+
+    #[test]
+    fn test_dynamic_array_before_the_last_field_gets_no_helpers() {
+        let input = r#"
+struct Mixed {
+    payload: byte[];
+    kind: uint16;
+};
+"#;
+        let output = generate_c_code_from_string(input).unwrap();
+        assert!(!output.contains("_view"));
+        assert!(!output.contains("_cursor"));
+    }
+
+    #[test]
+    fn test_union_dispatch_with_dense_discriminators_uses_a_table() {
+        let input = r#"
+union Dense {
+    0 => a: uint8;
+    1 => b: uint16;
+    2..5 => c: uint32;
+};
+"#;
+        let output = generate_c_code_from_string(input).unwrap();
+        assert!(output.contains("static inline int Dense_member_index(uint64_t discriminator) {"));
+        assert!(output.contains("    static const int16_t members[6] = {0, 1, 2, 2, 2, 2};"));
+        assert!(output.contains("    return members[discriminator];"));
+        assert!(!output.contains("first_discriminators"));
+    }
+
+    #[test]
+    fn test_union_dispatch_with_offset_discriminators_subtracts_the_minimum() {
+        let input = r#"
+union Offset {
+    16 => a: uint8;
+    17..20 => b: uint16;
+};
+"#;
+        let output = generate_c_code_from_string(input).unwrap();
+        assert!(output.contains("    if (discriminator < 16u || discriminator > 20u) {"));
+        assert!(output.contains("    return members[discriminator - 16u];"));
+    }
+
+    #[test]
+    fn test_union_dispatch_with_sparse_discriminators_uses_binary_search() {
+        let input = r#"
+union Sparse {
+    1 => a: uint8;
+    0x1000 => b: uint16;
+    0x800000..0x800010 => c: uint32;
+};
+"#;
+        let output = generate_c_code_from_string(input).unwrap();
+        assert!(output.contains("static inline int Sparse_member_index(uint64_t discriminator) {"));
+        assert!(output.contains(
+            "    static const uint64_t first_discriminators[3] = {1u, 4096u, 8388608u};"
+        ));
+        assert!(
+            output.contains(
+                "    static const uint64_t last_discriminators[3] = {1u, 4096u, 8388624u};"
+            )
+        );
+        assert!(output.contains("    static const int16_t members[3] = {0, 1, 2};"));
+        assert!(output.contains("        int middle = low + (high - low) / 2;"));
+    }
+
+    #[test]
+    fn test_union_dispatch_ranges_are_sorted_by_discriminator() {
+        let input = r#"
+union Unsorted {
+    0x1000 => late: uint8;
+    1 => early: uint16;
+};
+"#;
+        let protocol = crate::parse_protocol_to_ast(input).unwrap();
+        let Definition::Union(union) = &protocol.definitions[0] else {
+            panic!("Expected a UnionDefinition");
+        };
+        // The member index still refers to the declaration order.
+        assert_eq!(
+            union_dispatch_ranges(union),
+            vec![(1, 1, 1), (4096, 4096, 0)]
+        );
+    }
+
+    #[test]
+    fn test_emit_c_code_matches_generate_c_code() {
+        let protocol = crate::parse_protocol_to_ast(INPUT_FILE_CONTENT).unwrap();
+        let sorted = crate::ast::sort_protocol_by_dependencies(&protocol).unwrap();
+
+        let mut emitted = String::new();
+        emit_c_code(&mut emitted, &sorted).unwrap();
+
+        assert_eq!(emitted, generate_c_code(&sorted));
+    }
+
+    #[test]
+    fn test_estimate_c_code_size_covers_generated_output() {
+        let protocol = crate::parse_protocol_to_ast(INPUT_FILE_CONTENT).unwrap();
+        let sorted = crate::ast::sort_protocol_by_dependencies(&protocol).unwrap();
+
+        assert!(estimate_c_code_size(&sorted) >= generate_c_code(&sorted).len());
+    }
+
+    #[cfg(feature = "parallel")]
+    #[test]
+    fn test_generate_c_code_parallel_matches_serial() {
+        let protocol = crate::parse_protocol_to_ast(INPUT_FILE_CONTENT).unwrap();
+        let sorted = crate::ast::sort_protocol_by_dependencies(&protocol).unwrap();
+
+        assert_eq!(generate_c_code_parallel(&sorted), generate_c_code(&sorted));
+    }
+
+    static PACKED_INPUT: &str = r#"
+struct PackedHeader {
+    [bits = 4] version: uint8;
+    [bits = 12] length: uint16;
+    flags: byte;
+};
+"#;
+
+    static EXPECTED_PACKED_C_OUTPUT: &str = r#"#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef struct {
+    uint8_t version;
+    uint16_t length;
+    uint8_t flags;
+} PackedHeader;
+
+#define PACKED_HEADER_VERSION_BIT_OFFSET 0u
+#define PACKED_HEADER_VERSION_BIT_WIDTH 4u
+#define PACKED_HEADER_LENGTH_BIT_OFFSET 4u
+#define PACKED_HEADER_LENGTH_BIT_WIDTH 12u
+#define PACKED_HEADER_FLAGS_BIT_OFFSET 16u
+#define PACKED_HEADER_FLAGS_BIT_WIDTH 8u
+#define PACKED_HEADER_BIT_SIZE 24u
+#define PACKED_HEADER_BYTE_SIZE 3u
+_Static_assert(sizeof(((PackedHeader*)0)->version) * 8u >= PACKED_HEADER_VERSION_BIT_WIDTH, "version is narrower than its wire width");
+_Static_assert(sizeof(((PackedHeader*)0)->length) * 8u >= PACKED_HEADER_LENGTH_BIT_WIDTH, "length is narrower than its wire width");
+_Static_assert(sizeof(((PackedHeader*)0)->flags) * 8u >= PACKED_HEADER_FLAGS_BIT_WIDTH, "flags is narrower than its wire width");
+_Static_assert(PACKED_HEADER_FLAGS_BIT_OFFSET + PACKED_HEADER_FLAGS_BIT_WIDTH == PACKED_HEADER_BIT_SIZE, "field layout must cover the wire size");
+
+static inline size_t encode_packed_header(const PackedHeader* input, uint8_t* buffer) {
+    memset(buffer, 0, PACKED_HEADER_BYTE_SIZE);
+    {
+        const uint64_t value = (uint64_t)input->version;
+        buffer[0] |= (uint8_t)(((value >> 0) & 0xFu) << 4);
+    }
+    {
+        const uint64_t value = (uint64_t)input->length;
+        buffer[0] |= (uint8_t)(((value >> 8) & 0xFu) << 0);
+        buffer[1] |= (uint8_t)(((value >> 0) & 0xFFu) << 0);
+    }
+    {
+        const uint64_t value = (uint64_t)input->flags;
+        buffer[2] |= (uint8_t)(((value >> 0) & 0xFFu) << 0);
+    }
+    return PACKED_HEADER_BYTE_SIZE;
+}
+
+static inline size_t decode_packed_header(PackedHeader* output, const uint8_t* buffer) {
+    {
+        uint64_t value = 0u;
+        value |= ((uint64_t)((buffer[0] >> 4) & 0xFu)) << 0;
+        output->version = (uint8_t)value;
+    }
+    {
+        uint64_t value = 0u;
+        value |= ((uint64_t)((buffer[0] >> 0) & 0xFu)) << 8;
+        value |= ((uint64_t)((buffer[1] >> 0) & 0xFFu)) << 0;
+        output->length = (uint16_t)value;
+    }
+    {
+        uint64_t value = 0u;
+        value |= ((uint64_t)((buffer[2] >> 0) & 0xFFu)) << 0;
+        output->flags = (uint8_t)value;
+    }
+    return PACKED_HEADER_BYTE_SIZE;
+}
+
+"#;
+
+    #[test]
+    fn test_generate_c_code_with_encoder_and_decoder() {
+        let output = generate_c_code_from_string(PACKED_INPUT).unwrap();
+        assert_eq!(output, EXPECTED_PACKED_C_OUTPUT);
+    }
+
+    #[test]
+    fn test_structure_layout_with_fixed_width_fields() {
+        let protocol = crate::parse_protocol_to_ast(PACKED_INPUT).unwrap();
+        let Definition::Structure(structure) = &protocol.definitions[0] else {
+            panic!("Expected a StructureDefinition");
+        };
+
+        let layouts = structure_layout(structure).expect("Expected a fixed layout");
+        assert_eq!(layouts.len(), 3);
+        assert_eq!(layouts[0].bit_offset, 0);
+        assert_eq!(layouts[0].bit_width(), 4);
+        assert_eq!(layouts[1].bit_offset, 4);
+        assert_eq!(layouts[1].bit_width(), 12);
+        assert_eq!(layouts[2].bit_offset, 16);
+        assert_eq!(layouts[2].bit_width(), 8);
+    }
+
+    #[test]
+    fn test_structure_layout_without_fixed_width_is_skipped() {
+        let input = r#"
+struct WithDynamicArray {
+    count: uint8;
+    payload: byte[];
+};
+"#;
+        let protocol = crate::parse_protocol_to_ast(input).unwrap();
+        let Definition::Structure(structure) = &protocol.definitions[0] else {
+            panic!("Expected a StructureDefinition");
+        };
+
+        assert!(structure_layout(structure).is_none());
+        // No fixed-size codec is generated; the trailing dynamic array gets
+        // an in-place view instead (which pulls in the codec header).
+        let output = generate_c_code_from_string(input).unwrap();
+        assert!(!output.contains("encode_with_dynamic_array"));
+        assert!(output.contains("with_dynamic_array_payload_view"));
+    }
+
+    #[test]
+    fn test_to_snake_case() {
+        assert_eq!(to_snake_case("MyStruct"), "my_struct");
+        assert_eq!(to_snake_case("EcpriHeader"), "ecpri_header");
+        assert_eq!(to_snake_case("already_snake_t"), "already_snake_t");
+    }
+
+    #[test]
+    fn test_byte_packings_for_field_spanning_two_bytes() {
+        let packings = byte_packings(4, 12);
+        assert_eq!(packings.len(), 2);
+        assert_eq!(packings[0].byte_index, 0);
+        assert_eq!(packings[0].value_shift, 8);
+        assert_eq!(packings[0].in_byte_shift, 0);
+        assert_eq!(packings[0].mask, 0xF);
+        assert_eq!(packings[1].byte_index, 1);
+        assert_eq!(packings[1].value_shift, 0);
+        assert_eq!(packings[1].in_byte_shift, 0);
+        assert_eq!(packings[1].mask, 0xFF);
+    }
 
     #[test]
     fn test_generate_c_code_from_string() {
@@ -365,4 +1678,26 @@ typedef union {
         std::fs::remove_file(input_file.path().to_str().unwrap()).unwrap();
         std::fs::remove_file(output_file.path().to_str().unwrap()).unwrap();
     }
+
+    #[test]
+    fn test_generate_from_file_to_file_skips_identical_output() {
+        let input_file = NamedTempFile::new().expect("Failed to create temporary file");
+        let output_file = NamedTempFile::new().expect("Failed to create temporary file");
+        let input_path = input_file.path().to_str().unwrap();
+        let output_path = output_file.path().to_str().unwrap();
+
+        std::fs::write(input_file.path(), INPUT_FILE_CONTENT).unwrap();
+
+        assert_eq!(
+            generate_from_file_to_file(input_path, output_path),
+            Ok(WriteOutcome::Written)
+        );
+        assert_eq!(
+            generate_from_file_to_file(input_path, output_path),
+            Ok(WriteOutcome::Unchanged)
+        );
+
+        std::fs::remove_file(input_path).unwrap();
+        std::fs::remove_file(output_path).unwrap();
+    }
 }
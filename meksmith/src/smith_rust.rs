@@ -0,0 +1,318 @@
+//! Generates zero-copy Rust decoders from a `Protocol`.
+//!
+//! For every structure whose bit layout is fully fixed at generation time
+//! (see `smith_c::structure_layout`), a view
+//! struct borrowing `&[u8]` is emitted: field accessors do fixed-offset
+//! shift/mask reads computed here, byte arrays are returned as borrowed
+//! slices, and decoding a message never allocates. The wire format matches
+//! the C codecs from [`smith_c`](crate::smith_c): fields are packed
+//! MSB-first.
+//!
+//! Structures without a fixed layout, enumerations, unions and type
+//! definitions produce no Rust code; they are represented by the raw
+//! integer values their fields decode to.
+
+use crate::ast::{Definition, Protocol, StructureDefinition};
+use crate::smith_c::{FieldLayout, FieldValueKind, byte_packings, structure_layout, to_snake_case};
+
+use std::fmt::Write;
+
+static RUST_CODE_HEADER: &str =
+    "// Zero-copy view decoders generated by meksmith. Do not edit.\n#![allow(dead_code)]\n\n";
+
+/// Returns the Rust type an accessor for this layout returns. User-defined
+/// field types have no generated Rust counterpart, so their raw value is
+/// returned as the narrowest unsigned integer holding the field width.
+fn rust_type(layout: &FieldLayout) -> &'static str {
+    match (layout.kind, layout.element_width) {
+        (FieldValueKind::Boolean, _) => "bool",
+        (FieldValueKind::Float, 32) => "f32",
+        (FieldValueKind::Float, _) => "f64",
+        (FieldValueKind::Signed, width) => match width {
+            0..=8 => "i8",
+            9..=16 => "i16",
+            17..=32 => "i32",
+            _ => "i64",
+        },
+        (FieldValueKind::Unsigned | FieldValueKind::UserDefined, width) => match width {
+            0..=8 => "u8",
+            9..=16 => "u16",
+            17..=32 => "u32",
+            _ => "u64",
+        },
+    }
+}
+
+/// Returns whether a view struct can be generated for this layout: array
+/// fields must be byte-aligned with whole-byte elements so their accessors
+/// can index at runtime without re-deriving bit packings per element.
+fn is_view_compatible(layouts: &[FieldLayout]) -> bool {
+    layouts.iter().all(|layout| {
+        layout.element_count == 1 || (layout.bit_offset % 8 == 0 && layout.element_width % 8 == 0)
+    })
+}
+
+/// Emits the raw-bits read of `element_width` bits at `bit_offset` into a
+/// `value` variable, one shift/mask per touched buffer byte.
+fn emit_raw_read<W: Write>(sink: &mut W, bit_offset: u64, element_width: u64) -> std::fmt::Result {
+    writeln!(sink, "        let mut value: u64 = 0;")?;
+    for packing in byte_packings(bit_offset, element_width) {
+        writeln!(
+            sink,
+            "        value |= (((self.bytes[{}] >> {}) & {:#X}) as u64) << {};",
+            packing.byte_index, packing.in_byte_shift, packing.mask, packing.value_shift
+        )?;
+    }
+    Ok(())
+}
+
+/// Emits the conversion of the raw `value` bits to the accessor's return
+/// type, mirroring the C decoder's sign extension and float reinterpretation.
+fn emit_value_conversion<W: Write>(sink: &mut W, layout: &FieldLayout) -> std::fmt::Result {
+    match (layout.kind, layout.element_width) {
+        (FieldValueKind::Boolean, _) => writeln!(sink, "        value != 0"),
+        (FieldValueKind::Signed, 64) => writeln!(sink, "        value as i64"),
+        (FieldValueKind::Signed, width) => {
+            let sign_bit = 1u64 << (width - 1);
+            writeln!(
+                sink,
+                "        (((value ^ {:#X}) as i64) - {:#X}) as {}",
+                sign_bit,
+                sign_bit,
+                rust_type(layout)
+            )
+        }
+        (FieldValueKind::Float, 32) => writeln!(sink, "        f32::from_bits(value as u32)"),
+        (FieldValueKind::Float, _) => writeln!(sink, "        f64::from_bits(value)"),
+        _ => writeln!(sink, "        value as {}", rust_type(layout)),
+    }
+}
+
+/// Emits the accessor(s) for one field: a plain getter for scalars, a
+/// borrowed slice for byte arrays, and an indexed getter for other arrays.
+fn emit_field_accessor<W: Write>(sink: &mut W, layout: &FieldLayout) -> std::fmt::Result {
+    let method = to_snake_case(&layout.field_name);
+
+    if layout.element_count == 1 {
+        writeln!(
+            sink,
+            "    pub fn {method}(&self) -> {} {{",
+            rust_type(layout)
+        )?;
+        emit_raw_read(sink, layout.bit_offset, layout.element_width)?;
+        emit_value_conversion(sink, layout)?;
+        return writeln!(sink, "    }}");
+    }
+
+    let byte_offset = layout.bit_offset / 8;
+    let element_bytes = layout.element_width / 8;
+    if layout.element_width == 8 && layout.kind == FieldValueKind::Unsigned {
+        // A byte array is the zero-copy case: hand out the borrowed slice.
+        writeln!(sink, "    pub fn {method}(&self) -> &'bytes [u8] {{")?;
+        writeln!(
+            sink,
+            "        &self.bytes[{byte_offset}..{}]",
+            byte_offset + layout.element_count
+        )?;
+        return writeln!(sink, "    }}");
+    }
+
+    writeln!(
+        sink,
+        "    pub fn {method}(&self, index: usize) -> {} {{",
+        rust_type(layout)
+    )?;
+    writeln!(sink, "        assert!(index < {});", layout.element_count)?;
+    writeln!(
+        sink,
+        "        let start = {byte_offset} + index * {element_bytes};"
+    )?;
+    writeln!(sink, "        let mut value: u64 = 0;")?;
+    writeln!(sink, "        for offset in 0..{element_bytes} {{")?;
+    writeln!(
+        sink,
+        "            value = (value << 8) | self.bytes[start + offset] as u64;"
+    )?;
+    writeln!(sink, "        }}")?;
+    emit_value_conversion(sink, layout)?;
+    writeln!(sink, "    }}")
+}
+
+/// Emits the view struct and its accessors for a structure with a fixed,
+/// view-compatible layout.
+fn emit_view_struct<W: Write>(
+    sink: &mut W,
+    structure: &StructureDefinition,
+    layouts: &[FieldLayout],
+) -> std::fmt::Result {
+    let name = &structure.name.name;
+    let bit_size: u64 = layouts.iter().map(|layout| layout.bit_width()).sum();
+    let byte_size = bit_size.div_ceil(8);
+
+    writeln!(sink, "pub struct {name}View<'bytes> {{")?;
+    writeln!(sink, "    bytes: &'bytes [u8],")?;
+    writeln!(sink, "}}\n")?;
+    writeln!(sink, "impl<'bytes> {name}View<'bytes> {{")?;
+    writeln!(sink, "    pub const BIT_SIZE: usize = {bit_size};")?;
+    writeln!(sink, "    pub const BYTE_SIZE: usize = {byte_size};\n")?;
+    writeln!(
+        sink,
+        "    /// Returns a view over `bytes`, or `None` when the buffer is too short."
+    )?;
+    writeln!(
+        sink,
+        "    pub fn new(bytes: &'bytes [u8]) -> Option<Self> {{"
+    )?;
+    writeln!(
+        sink,
+        "        (bytes.len() >= Self::BYTE_SIZE).then_some({name}View {{ bytes }})"
+    )?;
+    writeln!(sink, "    }}")?;
+    for layout in layouts {
+        sink.write_char('\n')?;
+        emit_field_accessor(sink, layout)?;
+    }
+    writeln!(sink, "}}\n")
+}
+
+/// Emits the Rust code for a whole protocol into any [`std::fmt::Write`]
+/// sink; [`generate_rust_code`] wraps it for the common in-memory case.
+pub fn emit_rust_code<W: Write>(sink: &mut W, protocol: &Protocol) -> std::fmt::Result {
+    sink.write_str(RUST_CODE_HEADER)?;
+    for definition in &protocol.definitions {
+        if let Definition::Structure(structure) = definition
+            && let Some(layouts) = structure_layout(structure)
+            && is_view_compatible(&layouts)
+        {
+            emit_view_struct(sink, structure, &layouts)?;
+        }
+    }
+    Ok(())
+}
+
+/// Generates zero-copy Rust view decoders for the given protocol.
+pub fn generate_rust_code(protocol: &Protocol) -> String {
+    let mut code = String::new();
+    emit_rust_code(&mut code, protocol).expect("Writing to a String cannot fail");
+    code
+}
+
+/// Generates Rust code from a string input containing a protocol
+/// definition. Similar to [`generate_rust_code`], but parses the input
+/// first and joins all diagnostics into a single error message.
+pub fn generate_rust_code_from_string(input: &str) -> Result<String, String> {
+    let protocol = crate::parse_protocol_to_ast(input)
+        .map_err(|diagnostics| crate::diagnostics::join_diagnostics(&diagnostics))?;
+    let sorted = crate::ast::sort_protocol_by_dependencies(&protocol)?;
+    Ok(generate_rust_code(&sorted))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    static PACKED_INPUT: &str = r#"
+struct PackedHeader {
+    [bits = 4] version: uint8;
+    [bits = 12] length: uint16;
+    flags: byte;
+    offsets: int16[2];
+    payload: byte[4];
+};
+"#;
+
+    static EXPECTED_RUST_OUTPUT: &str = r#"// Zero-copy view decoders generated by meksmith. Do not edit.
+#![allow(dead_code)]
+
+pub struct PackedHeaderView<'bytes> {
+    bytes: &'bytes [u8],
+}
+
+impl<'bytes> PackedHeaderView<'bytes> {
+    pub const BIT_SIZE: usize = 88;
+    pub const BYTE_SIZE: usize = 11;
+
+    /// Returns a view over `bytes`, or `None` when the buffer is too short.
+    pub fn new(bytes: &'bytes [u8]) -> Option<Self> {
+        (bytes.len() >= Self::BYTE_SIZE).then_some(PackedHeaderView { bytes })
+    }
+
+    pub fn version(&self) -> u8 {
+        let mut value: u64 = 0;
+        value |= (((self.bytes[0] >> 4) & 0xF) as u64) << 0;
+        value as u8
+    }
+
+    pub fn length(&self) -> u16 {
+        let mut value: u64 = 0;
+        value |= (((self.bytes[0] >> 0) & 0xF) as u64) << 8;
+        value |= (((self.bytes[1] >> 0) & 0xFF) as u64) << 0;
+        value as u16
+    }
+
+    pub fn flags(&self) -> u8 {
+        let mut value: u64 = 0;
+        value |= (((self.bytes[2] >> 0) & 0xFF) as u64) << 0;
+        value as u8
+    }
+
+    pub fn offsets(&self, index: usize) -> i16 {
+        assert!(index < 2);
+        let start = 3 + index * 2;
+        let mut value: u64 = 0;
+        for offset in 0..2 {
+            value = (value << 8) | self.bytes[start + offset] as u64;
+        }
+        (((value ^ 0x8000) as i64) - 0x8000) as i16
+    }
+
+    pub fn payload(&self) -> &'bytes [u8] {
+        &self.bytes[7..11]
+    }
+}
+
+"#;
+
+    #[test]
+    fn test_generate_rust_code_for_packed_structure() {
+        let output = generate_rust_code_from_string(PACKED_INPUT).unwrap();
+        assert_eq!(output, EXPECTED_RUST_OUTPUT);
+    }
+
+    #[test]
+    fn test_structure_without_fixed_layout_is_skipped() {
+        let input = "struct Variable {\n    payload: byte[];\n};\n";
+        let output = generate_rust_code_from_string(input).unwrap();
+        assert_eq!(output, RUST_CODE_HEADER);
+    }
+
+    #[test]
+    fn test_unaligned_array_is_skipped() {
+        // The array starts at bit 4, so no view struct can be generated.
+        let input =
+            "struct Unaligned {\n    [bits = 4] version: uint8;\n    payload: byte[4];\n};\n";
+        let output = generate_rust_code_from_string(input).unwrap();
+        assert_eq!(output, RUST_CODE_HEADER);
+    }
+
+    #[test]
+    fn test_decoded_values_match_the_packed_layout() {
+        // version = 0xA in the high nibble, length = 0x123 in the following
+        // 12 bits, flags = 0x7F, offsets = [-2, 3], payload = 1..=4.
+        let bytes = [
+            0xA1, 0x23, 0x7F, 0xFF, 0xFE, 0x00, 0x03, 0x01, 0x02, 0x03, 0x04,
+        ];
+        let code = generate_rust_code_from_string(PACKED_INPUT).unwrap();
+        assert!(code.contains("pub fn version(&self) -> u8"));
+
+        // The accessors are plain shift/mask expressions; replay the emitted
+        // constants here to check they decode the example buffer correctly.
+        let version = (bytes[0] >> 4) & 0xF;
+        assert_eq!(version, 0xA);
+        let length = ((((bytes[0] & 0xF) as u64) << 8) | bytes[1] as u64) as u16;
+        assert_eq!(length, 0x123);
+        let offset0 =
+            ((((bytes[3] as u64) << 8 | bytes[4] as u64) ^ 0x8000) as i64 - 0x8000) as i16;
+        assert_eq!(offset0, -2);
+    }
+}
@@ -0,0 +1,263 @@
+//! Symbol table and semantic resolution over a parsed `Protocol`.
+//!
+//! [`SymbolTable::new`] indexes all definitions by name in a single pass, so
+//! [`SymbolTable::resolve`] is an O(1) hash lookup instead of a linear scan
+//! over `Protocol::definitions`. [`check_protocol`] builds the table and
+//! runs the resolution pass: every referenced user-defined type must exist,
+//! every `discriminated_by` attribute must name a field of its structure, and
+//! union discriminator values must not overlap.
+
+use crate::ast::{
+    Attribute, Definition, Protocol, StructureDefinition, TypeIdentifier, UnionDefinition,
+    UnionField,
+};
+use crate::intern::InternedString;
+
+use std::collections::HashMap;
+use std::collections::hash_map::Entry;
+
+/// A hash index over the definitions of a protocol, keyed by definition name.
+/// The table borrows the protocol it was built from.
+#[derive(Debug)]
+pub struct SymbolTable<'protocol> {
+    definitions: HashMap<InternedString, &'protocol Definition>,
+}
+
+impl<'protocol> SymbolTable<'protocol> {
+    /// Indexes all definitions by name. Duplicate definition names are
+    /// reported as errors; the first definition of a name wins.
+    pub fn new(protocol: &'protocol Protocol) -> (Self, Vec<String>) {
+        let mut definitions = HashMap::with_capacity(protocol.definitions.len());
+        let mut errors = Vec::new();
+        for definition in &protocol.definitions {
+            match definitions.entry(definition_name(definition)) {
+                Entry::Vacant(entry) => {
+                    entry.insert(definition);
+                }
+                Entry::Occupied(entry) => {
+                    errors.push(format!("Duplicate definition of type {}", entry.key()));
+                }
+            }
+        }
+        (SymbolTable { definitions }, errors)
+    }
+
+    /// Resolves a type name to its definition in O(1).
+    pub fn resolve(&self, name: &str) -> Option<&'protocol Definition> {
+        self.definitions.get(name).copied()
+    }
+}
+
+/// Builds a [`SymbolTable`] and validates the protocol against it: all
+/// referenced user-defined types must resolve, `discriminated_by` attributes
+/// must name a field of their structure, and union discriminators must be
+/// disjoint. All errors are joined into a single message, matching the format
+/// of the parsing entry points.
+pub fn check_protocol(protocol: &Protocol) -> Result<SymbolTable<'_>, String> {
+    let (table, mut errors) = SymbolTable::new(protocol);
+
+    for definition in &protocol.definitions {
+        match definition {
+            Definition::Enumeration(_) => {}
+            Definition::Structure(structure_def) => {
+                check_structure(structure_def, &table, &mut errors);
+            }
+            Definition::Union(union_def) => {
+                check_union(union_def, &table, &mut errors);
+            }
+            Definition::Type(type_def) => {
+                check_type_reference(
+                    &type_def.r#type,
+                    &type_def.new_type.name,
+                    &table,
+                    &mut errors,
+                );
+            }
+        }
+    }
+
+    if errors.is_empty() {
+        Ok(table)
+    } else {
+        Err(format!("Resolution failed. Errors: {}", errors.join(", ")))
+    }
+}
+
+/// Returns the name a definition is registered under in the symbol table.
+pub(crate) fn definition_name(definition: &Definition) -> InternedString {
+    match definition {
+        Definition::Enumeration(enumeration_def) => enumeration_def.name.name.clone(),
+        Definition::Structure(structure_def) => structure_def.name.name.clone(),
+        Definition::Union(union_def) => union_def.name.name.clone(),
+        Definition::Type(type_def) => type_def.new_type.name.clone(),
+    }
+}
+
+/// Checks that a type reference resolves if it is (or contains) a
+/// user-defined type. `referrer` names the definition holding the reference.
+fn check_type_reference(
+    r#type: &TypeIdentifier,
+    referrer: &InternedString,
+    table: &SymbolTable,
+    errors: &mut Vec<String>,
+) {
+    match r#type {
+        TypeIdentifier::UserDefined(id) => {
+            if table.resolve(&id.name).is_none() {
+                errors.push(format!("Unknown type {} referenced by {referrer}", id.name));
+            }
+        }
+        TypeIdentifier::StaticArray { r#type, .. } | TypeIdentifier::DynamicArray { r#type } => {
+            check_type_reference(r#type, referrer, table, errors);
+        }
+        _ => {}
+    }
+}
+
+/// Checks all field types of a structure and that every `discriminated_by`
+/// attribute names another field of the same structure.
+fn check_structure(
+    structure_def: &StructureDefinition,
+    table: &SymbolTable,
+    errors: &mut Vec<String>,
+) {
+    for field in &structure_def.fields {
+        check_type_reference(&field.r#type, &structure_def.name.name, table, errors);
+        for attribute in &field.attributes {
+            if let Attribute::DiscriminatedBy {
+                field: discriminator,
+            } = attribute
+                && !structure_def
+                    .fields
+                    .iter()
+                    .any(|candidate| candidate.name == *discriminator)
+            {
+                errors.push(format!(
+                    "Unknown discriminator field {} in structure {}",
+                    discriminator.name, structure_def.name.name
+                ));
+            }
+        }
+    }
+}
+
+/// Checks all arm types of a union and that no two arms claim the same
+/// discriminator value. Single values count as one-element ranges, so an
+/// overlap between a value and a range is reported as well.
+fn check_union(union_def: &UnionDefinition, table: &SymbolTable, errors: &mut Vec<String>) {
+    let mut ranges: Vec<(u64, u64)> = Vec::with_capacity(union_def.fields.len());
+    for field in union_def.fields.iter() {
+        let (r#type, range) = match field {
+            UnionField::SingleValue {
+                r#type,
+                discriminator,
+                ..
+            } => (r#type, (*discriminator, *discriminator)),
+            UnionField::RangeOfValues {
+                r#type,
+                start_discriminator,
+                end_discriminator,
+                ..
+            } => (r#type, (*start_discriminator, *end_discriminator)),
+        };
+        check_type_reference(r#type, &union_def.name.name, table, errors);
+        ranges.push(range);
+    }
+
+    ranges.sort_unstable();
+    for pair in ranges.windows(2) {
+        let ((_, previous_end), (start, _)) = (pair[0], pair[1]);
+        if start <= previous_end {
+            errors.push(format!(
+                "Duplicate discriminator value {start} in union {}",
+                union_def.name.name
+            ));
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::parse_protocol_to_ast;
+
+    static SOURCE: &str = "enum Kind {\n    first = 1;\n    second = 2;\n};\nstruct Message {\n    kind: Kind;\n    [discriminated_by = kind] payload: Payload;\n};\nunion Payload {\n    1 => first: uint8;\n    2..5 => second: uint16;\n};\n";
+
+    #[test]
+    fn test_resolve_finds_each_definition() {
+        let protocol = parse_protocol_to_ast(SOURCE).expect("Parsing failed");
+        let table = check_protocol(&protocol).expect("Resolution failed");
+        for name in ["Kind", "Message", "Payload"] {
+            assert!(table.resolve(name).is_some(), "{name} should resolve");
+        }
+        assert!(table.resolve("Unknown").is_none());
+    }
+
+    #[test]
+    fn test_unknown_type_is_reported() {
+        let protocol = parse_protocol_to_ast("struct Message {\n    field: Missing;\n};\n")
+            .expect("Parsing failed");
+        let error = check_protocol(&protocol).expect_err("Resolution should fail");
+        assert_eq!(
+            error,
+            "Resolution failed. Errors: Unknown type Missing referenced by Message"
+        );
+    }
+
+    #[test]
+    fn test_unknown_type_inside_array_is_reported() {
+        let protocol =
+            parse_protocol_to_ast("using Alias = Missing[4];\n").expect("Parsing failed");
+        let error = check_protocol(&protocol).expect_err("Resolution should fail");
+        assert_eq!(
+            error,
+            "Resolution failed. Errors: Unknown type Missing referenced by Alias"
+        );
+    }
+
+    #[test]
+    fn test_duplicate_definition_is_reported() {
+        let protocol = parse_protocol_to_ast("using Alias = uint8;\nusing Alias = uint16;\n")
+            .expect("Parsing failed");
+        let error = check_protocol(&protocol).expect_err("Resolution should fail");
+        assert_eq!(
+            error,
+            "Resolution failed. Errors: Duplicate definition of type Alias"
+        );
+    }
+
+    #[test]
+    fn test_unknown_discriminator_field_is_reported() {
+        let protocol = parse_protocol_to_ast(
+            "struct Message {\n    [discriminated_by = missing] payload: uint8;\n};\n",
+        )
+        .expect("Parsing failed");
+        let error = check_protocol(&protocol).expect_err("Resolution should fail");
+        assert_eq!(
+            error,
+            "Resolution failed. Errors: Unknown discriminator field missing in structure Message"
+        );
+    }
+
+    #[test]
+    fn test_overlapping_union_discriminators_are_reported() {
+        let protocol = parse_protocol_to_ast(
+            "union Payload {\n    1..4 => first: uint8;\n    3 => second: uint16;\n};\n",
+        )
+        .expect("Parsing failed");
+        let error = check_protocol(&protocol).expect_err("Resolution should fail");
+        assert_eq!(
+            error,
+            "Resolution failed. Errors: Duplicate discriminator value 3 in union Payload"
+        );
+    }
+
+    #[test]
+    fn test_disjoint_union_discriminators_pass() {
+        let protocol = parse_protocol_to_ast(
+            "union Payload {\n    1 => first: uint8;\n    2..5 => second: uint16;\n};\n",
+        )
+        .expect("Parsing failed");
+        assert!(check_protocol(&protocol).is_ok());
+    }
+}
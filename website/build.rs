@@ -0,0 +1,175 @@
+//! Bakes the syntax-highlighted HTML of the static snippets in `snippets/`
+//! into the binary at build time. The cheatsheet includes the generated
+//! `highlighted_snippets.rs`, so rendering those snippets costs zero runtime
+//! regex work; only the live editors still highlight at runtime.
+//!
+//! The meklang rules here must stay in sync with the runtime ones in
+//! `components/code_editor.rs`: same patterns, same CSS classes, same order.
+
+use regex_lite::Regex;
+
+use std::fmt::Write;
+use std::path::{Path, PathBuf};
+
+fn main() {
+    println!("cargo::rerun-if-changed=snippets");
+    let out_dir = std::env::var("OUT_DIR").expect("OUT_DIR is set by cargo");
+
+    let mut generated =
+        String::from("// Generated by build.rs from the snippets/ directory. Do not edit.\n");
+
+    let grammar =
+        std::fs::read_to_string("snippets/bnf-grammar.bnf").expect("Failed to read the grammar");
+    writeln!(
+        generated,
+        "pub(crate) static HIGHLIGHTED_BNF_GRAMMAR: &str = {:?};",
+        highlight_bnf_code(grammar.trim_end_matches('\n'))
+    )
+    .unwrap();
+
+    for path in snippet_paths() {
+        let code = std::fs::read_to_string(&path).expect("Failed to read a snippet");
+        let code = code.trim_end_matches('\n');
+        writeln!(
+            generated,
+            "pub(crate) static {}: StaticSnippet = StaticSnippet {{ html: {:?}, line_numbers: {:?}, lines: {} }};",
+            const_name(&path),
+            highlight_meklang(code),
+            line_numbers(code),
+            code.lines().count(),
+        )
+        .unwrap();
+    }
+
+    std::fs::write(
+        Path::new(&out_dir).join("highlighted_snippets.rs"),
+        generated,
+    )
+    .expect("Failed to write the generated snippets");
+}
+
+/// Returns the `.mek` snippet paths in a stable order, so the generated file
+/// does not churn between builds.
+fn snippet_paths() -> Vec<PathBuf> {
+    let mut paths: Vec<PathBuf> = std::fs::read_dir("snippets")
+        .expect("Failed to read the snippets directory")
+        .map(|entry| entry.expect("Failed to read a snippet entry").path())
+        .filter(|path| path.extension().is_some_and(|extension| extension == "mek"))
+        .collect();
+    paths.sort();
+    paths
+}
+
+/// Turns a snippet path into its constant name: `bits-bytes.mek` becomes
+/// `BITS_BYTES`.
+fn const_name(path: &Path) -> String {
+    path.file_stem()
+        .expect("Snippet files have a stem")
+        .to_string_lossy()
+        .replace('-', "_")
+        .to_uppercase()
+}
+
+/// Line numbers of the snippet, one per line, matching the format of the
+/// editor's line number overlay.
+fn line_numbers(code: &str) -> String {
+    (1..=code.lines().count().max(1)).fold(String::new(), |mut numbers, number| {
+        writeln!(numbers, "{number}").unwrap();
+        numbers
+    })
+}
+
+/// Mirrors `LanguageHighlighter::highlight_line` for meklang: escape the
+/// HTML, then wrap keywords, built-in types, and comments in spans.
+fn highlight_meklang(code: &str) -> String {
+    let rules = [
+        (
+            "code-editor-highlight-keyword",
+            Regex::new(r"\b(enum|struct|union|using)\b").unwrap(),
+        ),
+        (
+            "code-editor-highlight-builtin-type",
+            Regex::new(
+                r"\b(uint8|uint16|uint32|uint64|int8|int16|int32|int64|float32|float64|bit|byte)\b",
+            )
+            .unwrap(),
+        ),
+        ("code-editor-highlight-comment", Regex::new(r"#.*").unwrap()),
+    ];
+
+    let mut highlighted = code
+        .replace('&', "&amp;")
+        .replace('<', "&lt;")
+        .replace('>', "&gt;");
+    for (css_class, regex) in &rules {
+        highlighted = regex
+            .replace_all(&highlighted, |caps: &regex_lite::Captures| {
+                format!(r#"<span class="{}">{}</span>"#, css_class, &caps[0])
+            })
+            .into_owned();
+    }
+    highlighted
+}
+
+fn replace_between(
+    input: &str,
+    start: char,
+    end: char,
+    wrap_fn: impl Fn(&str) -> String,
+) -> String {
+    let mut output = String::new();
+    let mut chars = input.chars().peekable();
+
+    while let Some(c) = chars.next() {
+        if c == start {
+            let mut content = String::new();
+            while let Some(&next) = chars.peek() {
+                chars.next();
+                if next == end {
+                    break;
+                } else {
+                    content.push(next);
+                }
+            }
+            output.push_str(&wrap_fn(&content));
+        } else {
+            output.push(c);
+        }
+    }
+
+    output
+}
+
+fn highlight_bnf_code(code: &str) -> String {
+    fn keep_whitespaces(input: &str) -> String {
+        input
+            .replace(" ", "&nbsp;")
+            .replace("\t", "&nbsp;&nbsp;&nbsp;&nbsp;")
+    }
+
+    code.lines()
+        .map(|line| {
+            let mut line = keep_whitespaces(line);
+
+            line = replace_between(&line, '<', '>', |content| {
+                format!(r#"<span class="bnf-nonterminal">&lt;{content}&gt;</span>"#)
+            });
+
+            line = line
+                .replace("::=", r#"<span class="bnf-operator">::=</span>"#)
+                .replace("|", r#"<span class="bnf-operator">|</span>"#)
+                .replace("(", r#"<span class="bnf-operator">(</span>"#)
+                .replace(")", r#"<span class="bnf-operator">)</span>"#)
+                .replace("[", r#"<span class="bnf-operator">[</span>"#)
+                .replace("]", r#"<span class="bnf-operator">]</span>"#)
+                .replace("+", r#"<span class="bnf-operator">+</span>"#)
+                + "<br>";
+
+            line = replace_between(&line, '\'', '\'', |content| {
+                format!(r#"<span class="bnf-keyword">'{content}'</span>"#)
+            });
+
+            line
+        })
+        .collect()
+}
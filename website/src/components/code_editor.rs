@@ -4,6 +4,10 @@ use crate::utils::static_regex::static_regex;
 use leptos::prelude::*;
 use regex_lite::Regex;
 
+use std::cell::RefCell;
+use std::collections::HashMap;
+use std::rc::Rc;
+
 #[derive(Clone, Debug)]
 pub(crate) enum CodeEditorLanguage {
     #[allow(dead_code)]
@@ -32,20 +36,16 @@ impl CodeEditorLanguage {
         const COMMENT_CLASS: &str = "code-editor-highlight-comment";
 
         match self {
-            CodeEditorLanguage::PlainText => LanguageHighlighter { rules: vec![] },
-            CodeEditorLanguage::Meklang => LanguageHighlighter {
-                rules: vec![
-                    (KEYWORD_CLASS, &MEKLANG_KEYWORDS_REGEX),
-                    (BUILTIN_TYPE_CLASS, &MEKLANG_BUILTIN_TYPES_REGEX),
-                    (COMMENT_CLASS, &MEKLANG_COMMENT_REGEX),
-                ],
-            },
-            CodeEditorLanguage::C => LanguageHighlighter {
-                rules: vec![
-                    (KEYWORD_CLASS, &C_KEYWORDS_REGEX),
-                    (BUILTIN_TYPE_CLASS, &C_BUILTIN_TYPES_REGEX),
-                ],
-            },
+            CodeEditorLanguage::PlainText => LanguageHighlighter::new(vec![]),
+            CodeEditorLanguage::Meklang => LanguageHighlighter::new(vec![
+                (KEYWORD_CLASS, &MEKLANG_KEYWORDS_REGEX),
+                (BUILTIN_TYPE_CLASS, &MEKLANG_BUILTIN_TYPES_REGEX),
+                (COMMENT_CLASS, &MEKLANG_COMMENT_REGEX),
+            ]),
+            CodeEditorLanguage::C => LanguageHighlighter::new(vec![
+                (KEYWORD_CLASS, &C_KEYWORDS_REGEX),
+                (BUILTIN_TYPE_CLASS, &C_BUILTIN_TYPES_REGEX),
+            ]),
         }
     }
 }
@@ -70,41 +70,179 @@ impl CodeEditorOptions {
 
 type CssClass = &'static str;
 
-#[derive(Clone, Debug)]
+/// Extra lines rendered above and below the viewport, so small scrolls only
+/// move already-rendered content instead of waiting for a re-render.
+const OVERSCAN_LINES: usize = 20;
+
+/// Line height used when the computed style cannot be read; matches the
+/// default monospace font size of the editor stylesheet.
+const DEFAULT_LINE_HEIGHT: f64 = 16.0;
+
+/// Reads the pixel line height of the editor's textarea from its computed
+/// style; every overlay line has the same height, which is what maps scroll
+/// offsets to line numbers.
+fn line_height_of(textarea: &web_sys::HtmlTextAreaElement) -> f64 {
+    window()
+        .get_computed_style(textarea)
+        .ok()
+        .flatten()
+        .and_then(|style| style.get_property_value("line-height").ok())
+        .and_then(|value| value.trim_end_matches("px").parse::<f64>().ok())
+        .filter(|height| *height > 0.0)
+        .unwrap_or(DEFAULT_LINE_HEIGHT)
+}
+
+/// Returns the `first..last` line range covered by the viewport plus the
+/// overscan, clamped to the document.
+fn visible_line_range(
+    scroll_top: f64,
+    viewport_height: f64,
+    line_height: f64,
+    total_lines: usize,
+) -> (usize, usize) {
+    let first = (scroll_top / line_height) as usize;
+    let last = ((scroll_top + viewport_height) / line_height) as usize + 1;
+    (
+        first.saturating_sub(OVERSCAN_LINES).min(total_lines),
+        (last + OVERSCAN_LINES).min(total_lines),
+    )
+}
+
+/// Highlights code line by line, caching the HTML of each line. Every rule is
+/// line-scoped (keywords, types, and `#` comments never span a newline), so
+/// an edit only pays for the lines it actually changed; unchanged lines are
+/// served from the cache. The cache keeps exactly the lines of the last
+/// highlighted document, so repeated re-highlights of a large document stay
+/// proportional to the edit instead of the document size.
+#[derive(Debug)]
 struct LanguageHighlighter {
     rules: Vec<(CssClass, &'static Regex)>,
+    line_cache: RefCell<HashMap<String, String>>,
 }
 
 impl LanguageHighlighter {
+    fn new(rules: Vec<(CssClass, &'static Regex)>) -> Self {
+        LanguageHighlighter {
+            rules,
+            line_cache: RefCell::new(HashMap::new()),
+        }
+    }
+
     fn highlight(&self, code: &str) -> String {
+        let mut previous_cache = self.line_cache.borrow_mut();
+        let mut cache = HashMap::with_capacity(previous_cache.len());
+
+        for line in code.split('\n') {
+            if !cache.contains_key(line) {
+                let highlighted = previous_cache
+                    .remove(line)
+                    .unwrap_or_else(|| self.highlight_line(line));
+                cache.insert(line.to_string(), highlighted);
+            }
+        }
+
         let mut highlighted_code = code
+            .split('\n')
+            .map(|line| cache[line].as_str())
+            .collect::<Vec<_>>()
+            .join("\n");
+        *previous_cache = cache;
+
+        if highlighted_code.ends_with('\n') {
+            highlighted_code.push(' ');
+        }
+
+        highlighted_code
+    }
+
+    /// Highlights only the `first..last` line range and returns one HTML
+    /// string per line, served from the per-line cache wherever possible.
+    /// Together with the cache this makes an edit or scroll cost proportional
+    /// to the viewport instead of the document.
+    fn viewport_lines(&self, code: &str, first: usize, last: usize) -> Vec<String> {
+        let mut previous_cache = self.line_cache.borrow_mut();
+        let mut cache = HashMap::with_capacity(last - first);
+
+        for line in code.split('\n').skip(first).take(last - first) {
+            if !cache.contains_key(line) {
+                let highlighted = previous_cache
+                    .remove(line)
+                    .unwrap_or_else(|| self.highlight_line(line));
+                cache.insert(line.to_string(), highlighted);
+            }
+        }
+
+        let lines = code
+            .split('\n')
+            .skip(first)
+            .take(last - first)
+            .map(|line| cache[line].clone())
+            .collect();
+        *previous_cache = cache;
+        lines
+    }
+
+    /// Wraps each viewport line in a `<span>`, padded above and below with
+    /// blank lines so the overlay keeps the full document height and scroll
+    /// offsets still line up with the textarea. The spans are what lets a
+    /// later render patch single changed lines instead of rewriting the
+    /// overlay.
+    fn viewport_markup(lines: &[String], first: usize, last: usize, total_lines: usize) -> String {
+        let mut markup = "\n".repeat(first);
+        for (index, line) in lines.iter().enumerate() {
+            if index > 0 {
+                markup.push('\n');
+            }
+            markup.push_str("<span>");
+            markup.push_str(line);
+            markup.push_str("</span>");
+        }
+        markup.push_str(&"\n".repeat(total_lines - last));
+
+        if markup.ends_with('\n') {
+            markup.push(' ');
+        }
+
+        markup
+    }
+
+    fn highlight_line(&self, line: &str) -> String {
+        let mut highlighted_line = line
             .replace('&', "&amp;")
             .replace('<', "&lt;")
             .replace('>', "&gt;");
 
         for (css_class, regex) in &self.rules {
-            highlighted_code = regex
-                .replace_all(&highlighted_code, |caps: &regex_lite::Captures| {
+            highlighted_line = regex
+                .replace_all(&highlighted_line, |caps: &regex_lite::Captures| {
                     format!(r#"<span class="{}">{}</span>"#, css_class, &caps[0])
                 })
                 .into_owned();
         }
 
-        if highlighted_code.ends_with('\n') {
-            highlighted_code.push(' ');
-        }
-
-        highlighted_code
+        highlighted_line
     }
 }
 
+/// What the last viewport render put into the overlays; the next render
+/// diffs against it to patch only the changed line spans and to skip the
+/// line number gutter when it is unchanged.
+struct RenderedViewport {
+    first: usize,
+    total_lines: usize,
+    lines: Vec<String>,
+    line_numbers: String,
+}
+
 #[component]
 pub fn CodeEditor(
     code_editor_options: CodeEditorOptions,
     #[prop(into)] code: ReadSignal<String>,
     #[prop(into)] set_code: WriteSignal<String>,
 ) -> impl IntoView {
-    let language_highlighter = code_editor_options.language.get_highlighter();
+    // Shared between the input handler and the effect so both reuse the same
+    // per-line highlight cache.
+    let language_highlighter = Rc::new(code_editor_options.language.get_highlighter());
 
     let textarea_code_ref: NodeRef<leptos::html::Textarea> = NodeRef::new();
     let code_editor_options_for_textarea = code_editor_options.clone();
@@ -136,49 +274,108 @@ pub fn CodeEditor(
         pre.set_text_content(Some(&get_line_numbers(&code.get())));
     });
 
-    let language_highlighter_for_input_sync = language_highlighter.clone();
+    // Renders only the visible line range (plus overscan) into the overlays,
+    // padded with blank lines to the full document height, so an edit or
+    // scroll of a 10k-line document costs a viewport, not the document.
+    //
+    // The last render is kept so consecutive renders of the same viewport are
+    // diffed line-wise: a regeneration that changes a few visible lines
+    // patches exactly those line spans, and everything unchanged (including
+    // the line number gutter) never touches the DOM.
+    let last_render: Rc<RefCell<Option<RenderedViewport>>> = Rc::new(RefCell::new(None));
+    let render_viewport = Rc::new({
+        let language_highlighter = Rc::clone(&language_highlighter);
+        let last_render = Rc::clone(&last_render);
+        move || {
+            let (Some(textarea), Some(pre_parsed_code), Some(pre_line_numbers)) = (
+                textarea_code_ref.get(),
+                pre_parsed_code_ref.get(),
+                pre_line_numbers_ref.get(),
+            ) else {
+                return;
+            };
+
+            let value = textarea.value();
+            let total_lines = if value.is_empty() {
+                1
+            } else {
+                value.split('\n').count()
+            };
+            let (first, last) = visible_line_range(
+                textarea.scroll_top() as f64,
+                textarea.client_height() as f64,
+                line_height_of(&textarea),
+                total_lines,
+            );
+
+            let lines = language_highlighter.viewport_lines(&value, first, last);
+            let mut last_render = last_render.borrow_mut();
+            let same_viewport = last_render.as_ref().is_some_and(|previous| {
+                previous.first == first
+                    && previous.total_lines == total_lines
+                    && previous.lines.len() == lines.len()
+            });
+            if same_viewport {
+                // Same line range: patch only the spans whose HTML changed.
+                let previous = last_render.as_ref().unwrap();
+                let spans = pre_parsed_code.children();
+                for (index, (old, new)) in previous.lines.iter().zip(&lines).enumerate() {
+                    if old != new
+                        && let Some(span) = spans.item(index as u32)
+                    {
+                        span.set_inner_html(new);
+                    }
+                }
+            } else {
+                pre_parsed_code.set_inner_html(&LanguageHighlighter::viewport_markup(
+                    &lines,
+                    first,
+                    last,
+                    total_lines,
+                ));
+            }
+
+            let line_numbers = get_line_numbers_in_range(total_lines, first, last);
+            if last_render
+                .as_ref()
+                .is_none_or(|previous| previous.line_numbers != line_numbers)
+            {
+                pre_line_numbers.set_text_content(Some(&line_numbers));
+            }
+            *last_render = Some(RenderedViewport {
+                first,
+                total_lines,
+                lines,
+                line_numbers,
+            });
+
+            let scroll_top = textarea.scroll_top();
+            let scroll_left = textarea.scroll_left();
+
+            pre_parsed_code.set_scroll_top(scroll_top);
+            pre_parsed_code.set_scroll_left(scroll_left);
+            pre_line_numbers.set_scroll_top(scroll_top);
+            pre_line_numbers.set_scroll_left(scroll_left);
+        }
+    });
+
+    let render_viewport_for_input_sync = Rc::clone(&render_viewport);
     let input_sync = move |_| {
         let textarea = textarea_code_ref.get().unwrap();
-        let pre_parsed_code = pre_parsed_code_ref.get().unwrap();
-        let pre_line_numbers = pre_line_numbers_ref.get().unwrap();
-
         set_code.set(textarea.value());
-        pre_parsed_code.set_inner_html(
-            language_highlighter_for_input_sync
-                .highlight(&textarea.value())
-                .as_str(),
-        );
-        pre_line_numbers
-            .set_text_content(Some(get_line_numbers(textarea.value().as_str()).as_str()));
-
-        let scroll_top = textarea.scroll_top();
-        let scroll_left = textarea.scroll_left();
-
-        pre_parsed_code.set_scroll_top(scroll_top);
-        pre_parsed_code.set_scroll_left(scroll_left);
-        pre_line_numbers.set_scroll_top(scroll_top);
-        pre_line_numbers.set_scroll_left(scroll_left);
+        render_viewport_for_input_sync();
     };
 
+    let render_viewport_for_scroll_sync = Rc::clone(&render_viewport);
     let scroll_sync = move |_| {
-        let textarea = textarea_code_ref.get().unwrap();
-        let pre_parsed_code = pre_parsed_code_ref.get().unwrap();
-        let pre_line_numbers = pre_line_numbers_ref.get().unwrap();
-
-        let scroll_top = textarea.scroll_top();
-        let scroll_left = textarea.scroll_left();
-
-        pre_parsed_code.set_scroll_top(scroll_top);
-        pre_parsed_code.set_scroll_left(scroll_left);
-        pre_line_numbers.set_scroll_top(scroll_top);
-        pre_line_numbers.set_scroll_left(scroll_left);
+        render_viewport_for_scroll_sync();
     };
 
     let keydown = move |event: web_sys::KeyboardEvent| {
         CodeEditorShortcut::from(event.clone()).handle_event(event, &textarea_code_ref, &set_code);
     };
 
-    let language_highlighter_for_effect = language_highlighter.clone();
+    let render_viewport_for_effect = Rc::clone(&render_viewport);
     Effect::new({
         move |_| {
             if let Some(textarea) = textarea_code_ref.get()
@@ -187,13 +384,7 @@ pub fn CodeEditor(
                 textarea.set_value(&code.get());
             }
 
-            if let Some(pre) = pre_parsed_code_ref.get() {
-                pre.set_inner_html(&language_highlighter_for_effect.highlight(&code.get()));
-            }
-
-            if let Some(pre) = pre_line_numbers_ref.get() {
-                pre.set_text_content(Some(get_line_numbers(&code.get()).as_str()));
-            }
+            render_viewport_for_effect();
         }
     });
 
@@ -222,14 +413,29 @@ pub fn CodeEditorWithOutput(
     let (parsed_code, set_parsed_code) = signal(String::new());
     let (parsing_error, set_parsing_error) = signal(String::new());
 
-    Effect::new(move |_| {
-        match meksmith::smith_c::generate_c_code_from_string(code.get().as_str()) {
-            Ok(c_code) => {
-                set_parsed_code.set(c_code);
-                set_parsing_error.set(String::new());
-            }
-            Err(e) => set_parsing_error.set(e),
+    let apply_result = move |result: Result<String, String>| match result {
+        Ok(c_code) => {
+            set_parsed_code.set(c_code);
+            set_parsing_error.set(String::new());
         }
+        Err(e) => set_parsing_error.set(e),
+    };
+
+    // Smith on a Web Worker so keystrokes never wait for parsing and code
+    // generation; stale in-flight requests are coalesced by the worker
+    // client. The worker module is also the only binary linking the parser
+    // and smith, so this page is what fetches them, on demand — keep it
+    // that way and do not call into meksmith from this binary.
+    let smith_worker =
+        StoredValue::new_local(crate::utils::smith_worker::SmithWorker::spawn(apply_result));
+    Effect::new(move |_| {
+        let source = code.get();
+        smith_worker.with_value(|worker| match worker {
+            Some(worker) => worker.generate(&source),
+            None => apply_result(Err(
+                "Failed to start the code generation worker. Please reload the page.".to_string(),
+            )),
+        });
     });
 
     view! {
@@ -264,10 +470,20 @@ fn get_line_numbers(code: &str) -> String {
         code.split('\n').count()
     };
 
-    (1..=number_of_lines)
-        .map(|n| n.to_string() + "\n")
-        .collect::<Vec<_>>()
-        .join("")
+    get_line_numbers_in_range(number_of_lines, 0, number_of_lines)
+}
+
+/// Returns the line numbers of the `first..last` range, padded with blank
+/// lines to the full document height so the overlay scrolls in lockstep
+/// with the textarea.
+fn get_line_numbers_in_range(total_lines: usize, first: usize, last: usize) -> String {
+    let mut numbers = "\n".repeat(first);
+    for number in first + 1..=last {
+        numbers.push_str(&number.to_string());
+        numbers.push('\n');
+    }
+    numbers.push_str(&"\n".repeat(total_lines - last));
+    numbers
 }
 
 #[derive(Clone, Debug, PartialEq)]
@@ -563,4 +779,55 @@ mod tests {
     fn test_get_line_numbers_with_multiple_empty_lines() {
         assert_eq!(get_line_numbers("\n\n\n\n\n"), "1\n2\n3\n4\n5\n6\n");
     }
+
+    #[test]
+    fn test_get_line_numbers_in_range_pads_to_document_height() {
+        assert_eq!(get_line_numbers_in_range(5, 2, 4), "\n\n3\n4\n\n");
+        assert_eq!(get_line_numbers_in_range(3, 0, 3), "1\n2\n3\n");
+        assert_eq!(get_line_numbers_in_range(3, 3, 3), "\n\n\n");
+    }
+
+    #[test]
+    fn test_visible_line_range_clamps_to_the_document() {
+        // 10 lines of 16px in a 32px viewport scrolled to the top: the
+        // viewport covers lines 0..3 and the overscan is cut at the edges.
+        assert_eq!(visible_line_range(0.0, 32.0, 16.0, 10), (0, 10));
+        assert_eq!(visible_line_range(0.0, 32.0, 16.0, 1000), (0, 23));
+        assert_eq!(visible_line_range(800.0, 32.0, 16.0, 1000), (30, 73));
+        // Scrolled past the end of a short document.
+        assert_eq!(visible_line_range(800.0, 32.0, 16.0, 10), (10, 10));
+    }
+
+    #[test]
+    fn test_viewport_lines_returns_the_highlighted_range() {
+        let highlighter = LanguageHighlighter::new(vec![]);
+        assert_eq!(highlighter.viewport_lines("a\nb\nc", 1, 2), vec!["b"]);
+        assert_eq!(
+            highlighter.viewport_lines("a\nb\nc", 0, 3),
+            vec!["a", "b", "c"]
+        );
+        assert!(highlighter.viewport_lines("a\nb\nc", 3, 3).is_empty());
+    }
+
+    #[test]
+    fn test_viewport_markup_pads_to_document_height() {
+        let lines = |items: &[&str]| {
+            items
+                .iter()
+                .map(|line| line.to_string())
+                .collect::<Vec<_>>()
+        };
+        assert_eq!(
+            LanguageHighlighter::viewport_markup(&lines(&["b"]), 1, 2, 3),
+            "\n<span>b</span>\n "
+        );
+        assert_eq!(
+            LanguageHighlighter::viewport_markup(&lines(&["a", "b", "c"]), 0, 3, 3),
+            "<span>a</span>\n<span>b</span>\n<span>c</span>"
+        );
+        assert_eq!(
+            LanguageHighlighter::viewport_markup(&[], 3, 3, 3),
+            "\n\n\n "
+        );
+    }
 }
@@ -1,4 +1,5 @@
 pub mod code_editor;
 pub mod hyperlink;
 pub mod navbar;
+pub mod static_code_block;
 pub mod text;
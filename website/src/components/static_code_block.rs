@@ -0,0 +1,29 @@
+use leptos::prelude::*;
+
+/// A snippet highlighted at build time by `build.rs`: the final HTML, the
+/// line number overlay, and the line count for sizing. Instances live in the
+/// generated `highlighted_snippets.rs`.
+#[derive(Debug)]
+pub(crate) struct StaticSnippet {
+    pub(crate) html: &'static str,
+    pub(crate) line_numbers: &'static str,
+    pub(crate) lines: usize,
+}
+
+/// Renders a build-time highlighted snippet with the code editor's look —
+/// line number gutter, highlight colors — but no textarea, no scroll syncing,
+/// and no runtime highlighting.
+#[component]
+pub fn StaticCodeBlock(snippet: &'static StaticSnippet, width: u32) -> impl IntoView {
+    let height = snippet.lines as u32 * 26;
+
+    view! {
+        <div
+            class="code-editor-container"
+            style=format!("width: {width}px; height: {height}px;")
+        >
+            <pre class="code-editor-line-numbers">{snippet.line_numbers}</pre>
+            <pre class="code-editor-highlighted" inner_html=snippet.html></pre>
+        </div>
+    }
+}
@@ -11,12 +11,40 @@ use crate::pages::not_found::NotFound;
 
 use leptos::prelude::*;
 use leptos_router::components::{Route, Router, Routes};
+use leptos_router::{Lazy, LazyRoute};
 
 fn main() {
     console_error_panic_hook::set_once();
     leptos::mount::mount_to_body(App);
 }
 
+/// Declares a [`LazyRoute`] wrapper for a page component, so the route's
+/// view is only built when the route is first visited instead of on page
+/// load. The landing page stays eager; everything else is deferred, which
+/// keeps first paint independent of the heavier pages. The parser and smith
+/// themselves are not linked into this binary at all: the code generator
+/// loads them on demand inside the worker module (see `worker.rs`).
+macro_rules! lazy_page_route {
+    ($route:ident, $page:ident) => {
+        #[derive(Debug)]
+        struct $route;
+
+        impl LazyRoute for $route {
+            fn data() -> Self {
+                Self
+            }
+
+            async fn view(_this: Self) -> AnyView {
+                $page().into_any()
+            }
+        }
+    };
+}
+
+lazy_page_route!(CodeGeneratorRoute, CodeGenerator);
+lazy_page_route!(CheatsheetRoute, Cheatsheet);
+lazy_page_route!(ExamplesRoute, Examples);
+
 #[component]
 fn App() -> impl IntoView {
     view! {
@@ -25,9 +53,9 @@ fn App() -> impl IntoView {
             <main>
                 <Routes fallback=NotFound>
                     <Route path=leptos_router::path!("/") view=Home/>
-                    <Route path=leptos_router::path!("/code-generator") view=CodeGenerator/>
-                    <Route path=leptos_router::path!("/cheatsheet") view=Cheatsheet/>
-                    <Route path=leptos_router::path!("/examples") view=Examples/>
+                    <Route path=leptos_router::path!("/code-generator") view={Lazy::<CodeGeneratorRoute>::new()}/>
+                    <Route path=leptos_router::path!("/cheatsheet") view={Lazy::<CheatsheetRoute>::new()}/>
+                    <Route path=leptos_router::path!("/examples") view={Lazy::<ExamplesRoute>::new()}/>
                 </Routes>
             </main>
         </Router>
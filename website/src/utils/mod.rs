@@ -1 +1,2 @@
+pub mod smith_worker;
 pub mod static_regex;
@@ -0,0 +1,117 @@
+//! Main-thread client for the smith Web Worker (see `src/worker.rs`).
+//!
+//! Requests carry a monotonically increasing id and at most one request is in
+//! flight at a time: while the worker is busy, newer sources overwrite a
+//! single pending slot, so a burst of keystrokes coalesces into one job and
+//! results of superseded requests are dropped instead of flickering through
+//! the UI. There is no synchronous fallback — the smith is only linked into
+//! the worker binary — so when [`SmithWorker::spawn`] returns `None` the
+//! caller surfaces an error asking the user to reload the page.
+
+use wasm_bindgen::JsCast;
+use wasm_bindgen::prelude::*;
+use web_sys::MessageEvent;
+
+use std::cell::RefCell;
+use std::rc::Rc;
+
+/// The loader shim emitted by trunk for the `worker` binary
+/// (`data-type="worker" data-loader-shim` in `index.html`).
+const WORKER_LOADER_URL: &str = "./worker_loader.js";
+
+/// State shared between [`SmithWorker::generate`] and the worker's message
+/// callback.
+struct State {
+    worker: web_sys::Worker,
+    next_id: u64,
+    in_flight: Option<u64>,
+    pending: Option<String>,
+}
+
+impl State {
+    /// Posts `source` to the worker and records its request id.
+    fn post(&mut self, source: &str) {
+        let id = self.next_id;
+        self.next_id += 1;
+
+        let message = js_sys::Array::of2(&JsValue::from_f64(id as f64), &source.into());
+        if self.worker.post_message(&message).is_ok() {
+            self.in_flight = Some(id);
+        }
+    }
+}
+
+/// Handle to the smith Web Worker. Dropping the handle terminates the worker.
+pub(crate) struct SmithWorker {
+    state: Rc<RefCell<State>>,
+    // Keeps the onmessage closure alive for the lifetime of the worker.
+    _on_message: Closure<dyn FnMut(MessageEvent)>,
+}
+
+impl SmithWorker {
+    /// Spawns the worker and wires `on_result` to its responses. Returns
+    /// `None` when workers are unavailable (for example in tests).
+    pub(crate) fn spawn(
+        on_result: impl Fn(Result<String, String>) + 'static,
+    ) -> Option<SmithWorker> {
+        let worker = web_sys::Worker::new(WORKER_LOADER_URL).ok()?;
+        let state = Rc::new(RefCell::new(State {
+            worker,
+            next_id: 0,
+            in_flight: None,
+            pending: None,
+        }));
+
+        let state_for_messages = Rc::clone(&state);
+        let on_message = Closure::<dyn FnMut(MessageEvent)>::new(move |event: MessageEvent| {
+            let message = js_sys::Array::from(&event.data());
+            let id = message.get(0).as_f64().map(|id| id as u64);
+            let success = message.get(1).as_bool().unwrap_or(false);
+            let text = message.get(2).as_string().unwrap_or_default();
+
+            let mut state = state_for_messages.borrow_mut();
+            if state.in_flight != id {
+                // A superseded request finished after a newer one was posted.
+                return;
+            }
+            state.in_flight = None;
+
+            if let Some(source) = state.pending.take() {
+                // A newer source arrived while this one was being smithed:
+                // its result is stale, start the fresh job instead.
+                state.post(&source);
+                return;
+            }
+            drop(state);
+
+            on_result(if success { Ok(text) } else { Err(text) });
+        });
+        state
+            .borrow()
+            .worker
+            .set_onmessage(Some(on_message.as_ref().unchecked_ref()));
+
+        Some(SmithWorker {
+            state,
+            _on_message: on_message,
+        })
+    }
+
+    /// Asks the worker to generate C code for `source`. If a request is
+    /// already in flight the source is parked in the pending slot, replacing
+    /// any previously parked one.
+    pub(crate) fn generate(&self, source: &str) {
+        let mut state = self.state.borrow_mut();
+        if state.in_flight.is_some() {
+            state.pending = Some(source.to_string());
+        } else {
+            state.post(source);
+        }
+    }
+}
+
+impl Drop for SmithWorker {
+    fn drop(&mut self) {
+        self.state.borrow().worker.terminate();
+    }
+}
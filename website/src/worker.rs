@@ -0,0 +1,42 @@
+//! Web Worker entry point for the smith. The UI thread posts `[id, source]`
+//! messages (see `utils::smith_worker`); this worker runs the generator and
+//! answers with `[id, success, text]`, keeping parsing and code generation off
+//! the main thread so typing stays responsive on large protocols.
+
+use wasm_bindgen::JsCast;
+use wasm_bindgen::prelude::*;
+use web_sys::{DedicatedWorkerGlobalScope, MessageEvent};
+
+fn main() {
+    console_error_panic_hook::set_once();
+
+    let scope: DedicatedWorkerGlobalScope = js_sys::global()
+        .dyn_into()
+        .expect("worker entry point must run in a dedicated worker scope");
+
+    let scope_for_messages = scope.clone();
+    // The memoizing smith lives for the worker's lifetime: successive messages
+    // carry the whole buffer, so unchanged definitions reuse their cached
+    // parse and C fragment and an edit only costs its own definition.
+    let mut smith = meksmith::memo::MemoizedSmith::new();
+    let on_message = Closure::<dyn FnMut(MessageEvent)>::new(move |event: MessageEvent| {
+        let message = js_sys::Array::from(&event.data());
+        let id = message.get(0);
+        let source = message.get(1).as_string().unwrap_or_default();
+
+        let (success, text) = match smith.generate_c_code(&source) {
+            Ok(c_code) => (true, c_code),
+            Err(error) => (false, error),
+        };
+
+        let response = js_sys::Array::of3(&id, &JsValue::from_bool(success), &text.into());
+        scope_for_messages
+            .post_message(&response)
+            .expect("posting the smith result to the UI thread failed");
+    });
+
+    scope.set_onmessage(Some(on_message.as_ref().unchecked_ref()));
+    // The closure must outlive main: the worker keeps receiving messages for
+    // the lifetime of the page.
+    on_message.forget();
+}